@@ -413,100 +413,133 @@ expr_t::ptr_op_t account_t::lookup(const symbol_t::kind_t kind,
   if (kind != symbol_t::FUNCTION)
     return NULL;
 
-  switch (fn_name[0]) {
-  case 'a':
+  switch (hash_name(fn_name.c_str())) {
+  case hash_name("a"):
+  case hash_name("amount"):
     if (fn_name[1] == '\0' || fn_name == "amount")
       return WRAP_FUNCTOR(get_wrapper<&get_amount>);
-    else if (fn_name == "account")
+    break;
+  case hash_name("account"):
+    if (fn_name == "account")
       return WRAP_FUNCTOR(&get_account);
-    else if (fn_name == "account_base")
+    break;
+  case hash_name("account_base"):
+    if (fn_name == "account_base")
       return WRAP_FUNCTOR(get_wrapper<&get_account_base>);
-    else if (fn_name == "addr")
+    break;
+  case hash_name("addr"):
+    if (fn_name == "addr")
       return WRAP_FUNCTOR(get_wrapper<&get_addr>);
-    else if (fn_name == "any")
+    break;
+  case hash_name("any"):
+    if (fn_name == "any")
       return WRAP_FUNCTOR(&fn_any);
-    else if (fn_name == "all")
+    break;
+  case hash_name("all"):
+    if (fn_name == "all")
       return WRAP_FUNCTOR(&fn_all);
     break;
 
-  case 'c':
+  case hash_name("count"):
     if (fn_name == "count")
       return WRAP_FUNCTOR(get_wrapper<&get_count>);
-    else if (fn_name == "cost")
+    break;
+  case hash_name("cost"):
+    if (fn_name == "cost")
       return WRAP_FUNCTOR(get_wrapper<&get_cost>);
     break;
 
-  case 'd':
+  case hash_name("depth"):
     if (fn_name == "depth")
       return WRAP_FUNCTOR(get_wrapper<&get_depth>);
-    else if (fn_name == "depth_parent")
+    break;
+  case hash_name("depth_parent"):
+    if (fn_name == "depth_parent")
       return WRAP_FUNCTOR(get_wrapper<&get_depth_parent>);
-    else if (fn_name == "depth_spacer")
+    break;
+  case hash_name("depth_spacer"):
+    if (fn_name == "depth_spacer")
       return WRAP_FUNCTOR(get_wrapper<&get_depth_spacer>);
     break;
 
-  case 'e':
+  case hash_name("earliest"):
     if (fn_name == "earliest")
       return WRAP_FUNCTOR(get_wrapper<&get_earliest>);
-    else if (fn_name == "earliest_checkin")
+    break;
+  case hash_name("earliest_checkin"):
+    if (fn_name == "earliest_checkin")
       return WRAP_FUNCTOR(get_wrapper<&get_earliest_checkin>);
     break;
 
-  case 'i':
+  case hash_name("is_account"):
     if (fn_name == "is_account")
       return WRAP_FUNCTOR(get_wrapper<&get_true>);
-    else if (fn_name == "is_index")
+    break;
+  case hash_name("is_index"):
+    if (fn_name == "is_index")
       return WRAP_FUNCTOR(get_wrapper<&get_subcount>);
     break;
 
-  case 'l':
+  case hash_name("l"):
     if (fn_name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_depth>);
-    else if (fn_name == "latest_cleared")
+    break;
+  case hash_name("latest_cleared"):
+    if (fn_name == "latest_cleared")
       return WRAP_FUNCTOR(get_wrapper<&get_latest_cleared>);
-    else if (fn_name == "latest")
+    break;
+  case hash_name("latest"):
+    if (fn_name == "latest")
       return WRAP_FUNCTOR(get_wrapper<&get_latest>);
-    else if (fn_name == "latest_checkout")
+    break;
+  case hash_name("latest_checkout"):
+    if (fn_name == "latest_checkout")
       return WRAP_FUNCTOR(get_wrapper<&get_latest_checkout>);
-    else if (fn_name == "latest_checkout_cleared")
+    break;
+  case hash_name("latest_checkout_cleared"):
+    if (fn_name == "latest_checkout_cleared")
       return WRAP_FUNCTOR(get_wrapper<&get_latest_checkout_cleared>);
     break;
 
-  case 'n':
+  case hash_name("n"):
     if (fn_name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_subcount>);
-    else if (fn_name == "note")
+    break;
+  case hash_name("note"):
+    if (fn_name == "note")
       return WRAP_FUNCTOR(get_wrapper<&get_note>);
     break;
 
-  case 'p':
+  case hash_name("partial_account"):
     if (fn_name == "partial_account")
       return WRAP_FUNCTOR(get_partial_name);
-    else if (fn_name == "parent")
+    break;
+  case hash_name("parent"):
+    if (fn_name == "parent")
       return WRAP_FUNCTOR(get_wrapper<&get_parent>);
     break;
 
-  case 's':
+  case hash_name("subcount"):
     if (fn_name == "subcount")
       return WRAP_FUNCTOR(get_wrapper<&get_subcount>);
     break;
 
-  case 't':
+  case hash_name("total"):
     if (fn_name == "total")
       return WRAP_FUNCTOR(get_wrapper<&get_total>);
     break;
 
-  case 'u':
+  case hash_name("use_direct_amount"):
     if (fn_name == "use_direct_amount")
       return WRAP_FUNCTOR(get_wrapper<&ignore>);
     break;
 
-  case 'N':
+  case hash_name("N"):
     if (fn_name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_count>);
     break;
 
-  case 'O':
+  case hash_name("O"):
     if (fn_name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_total>);
     break;
@@ -669,6 +702,133 @@ value_t account_t::total(const optional<expr_t&>& expr) const
   return xdata_->family_details.total;
 }
 
+namespace {
+  typedef std::pair<account_t *, post_t *>        account_post_t;
+  typedef std::pair<account_t *, commodity_t *>   amount_key_t;
+
+  // The sums of one slice of postings, for each account and commodity.
+  // Postings whose value cannot be summed without GMP are left over, to
+  // be added afterward on the calling thread.
+  struct amounts_shard_t
+  {
+    std::map<amount_key_t, amount_t> sums;
+    std::vector<std::size_t>         leftover;
+  };
+
+  // Collect the accounts whose amount() has not yet been asked for.
+  // Postings reported under another account are only summed in the order
+  // amount() is called, so no sharding is done if there are any.
+  bool find_unsummed_accounts(account_t& account,
+                              std::vector<account_t *>& accounts)
+  {
+    if (account.has_xflags(ACCOUNT_EXT_VISITED)) {
+      account_t::xdata_t& xdata(account.xdata());
+      if (! xdata.reported_posts.empty() ||
+          xdata.self_details.last_post ||
+          xdata.self_details.last_reported_post ||
+          ! xdata.self_details.total.is_null())
+        return false;
+      accounts.push_back(&account);
+    }
+    foreach (accounts_map::value_type& pair, account.accounts)
+      if (! find_unsummed_accounts(*pair.second, accounts))
+        return false;
+    return true;
+  }
+
+  // Mirrors post_t::add_to_value, for values which are inline amounts.
+  void sum_posts(const account_post_t * posts, std::size_t first,
+                 std::size_t count, amounts_shard_t& shard)
+  {
+    for (std::size_t i = first; i < first + count; i++) {
+      const post_t&          post(*posts[i].second);
+      const post_t::xdata_t& xdata(post.xdata());
+      const amount_t *       amt = NULL;
+
+      if (xdata.has_flags(POST_EXT_COMPOUND)) {
+        if (xdata.compound_value.is_null())
+          continue;
+        if (xdata.compound_value.is_amount())
+          amt = &xdata.compound_value.as_amount();
+      }
+      else if (! xdata.visited_value.is_null()) {
+        if (xdata.visited_value.is_amount())
+          amt = &xdata.visited_value.as_amount();
+      }
+      else {
+        amt = &post.amount;
+      }
+
+      if (! (amt && shard.sums[amount_key_t(posts[i].first,
+                                            amt->commodity_ptr())]
+             .add_inline(*amt)))
+        shard.leftover.push_back(i);
+    }
+  }
+}
+
+void sum_accounts(account_t& master, const std::size_t threads)
+{
+  std::vector<account_t *> accounts;
+  if (! find_unsummed_accounts(master, accounts))
+    return;
+
+  std::vector<account_post_t> posts;
+  foreach (account_t * account, accounts) {
+    foreach (post_t * post, account->posts) {
+      if (post->has_xdata() &&
+          post->xdata().has_flags(POST_EXT_VISITED) &&
+          ! post->xdata().has_flags(POST_EXT_CONSIDERED)) {
+        posts.push_back(account_post_t(account, post));
+        post->xdata().add_flags(POST_EXT_CONSIDERED);
+      }
+    }
+    if (! account->posts.empty())
+      account->xdata().self_details.last_post = --account->posts.end();
+  }
+
+  std::size_t slices =
+    std::max(std::size_t(1), std::min(threads, posts.size() / 256));
+  std::vector<amounts_shard_t> shards(slices);
+
+  std::vector<std::future<void> > workers;
+  try {
+    for (std::size_t i = 1; i < slices; i++) {
+      std::size_t first = posts.size() * i / slices;
+      std::size_t count = posts.size() * (i + 1) / slices - first;
+      try {
+        workers.push_back(std::async(std::launch::async, sum_posts,
+                                     &posts[0], first, count,
+                                     std::ref(shards[i])));
+      }
+      catch (const std::system_error&) {
+        sum_posts(&posts[0], first, count, shards[i]);
+      }
+    }
+    if (! posts.empty())
+      sum_posts(&posts[0], 0, posts.size() / slices, shards[0]);
+  }
+  catch (...) {
+    foreach (std::future<void>& worker, workers)
+      worker.wait();
+    throw;
+  }
+  foreach (std::future<void>& worker, workers)
+    worker.get();
+
+  // The sum is associative, so the shards may be merged in any order.
+  foreach (amounts_shard_t& shard, shards) {
+    typedef std::map<amount_key_t, amount_t>::value_type sum_t;
+    foreach (sum_t& sum, shard.sums)
+      if (! sum.second.is_null())
+        add_or_set_value(sum.first.first->xdata().self_details.total,
+                         sum.second);
+    foreach (std::size_t i, shard.leftover)
+      posts[i].second->add_to_value
+        (posts[i].first->xdata().self_details.total);
+  }
+}
+
 const account_t::xdata_t::details_t&
 account_t::self_details(bool gather_all) const
 {
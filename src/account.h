@@ -151,6 +151,9 @@ public:
 
   virtual expr_t::ptr_op_t lookup(const symbol_t::kind_t kind,
                                   const string& name);
+  virtual bool lookup_by_type() const {
+    return true;
+  }
 
   bool valid() const;
 
@@ -292,6 +295,11 @@ public:
 
 std::ostream& operator<<(std::ostream& out, const account_t& account);
 
+/** Sum the amounts of every visited account under `master' on up to
+    `threads' threads, as account_t::amount() would, so that later calls
+    to it find the total already computed. */
+void sum_accounts(account_t& master, std::size_t threads);
+
 void put_account(property_tree::ptree& pt, const account_t& acct,
                  function<bool(const account_t&)> pred);
 
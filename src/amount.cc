@@ -46,6 +46,8 @@ bool amount_t::stream_fullstrings = false;
 // efficiency, and are reused over and over again.
 static mpz_t  temp;
 static mpq_t  tempq;
+static mpq_t  tempqa;
+static mpq_t  tempqb;
 static mpfr_t tempf;
 static mpfr_t tempfb;
 static mpfr_t tempfnum;
@@ -81,6 +83,9 @@ struct amount_t::bigint_t : public supports_flags<>
     mpq_clear(val);
   }
 
+  static void * operator new(std::size_t size);
+  static void   operator delete(void * ptr, std::size_t size);
+
   bool valid() const {
     if (prec > 1024) {
       DEBUG("ledger.validate", "amount_t::bigint_t: prec > 1024");
@@ -97,9 +102,154 @@ struct amount_t::bigint_t : public supports_flags<>
 
 bool amount_t::is_initialized = false;
 
+namespace {
+  // Every quantity needs a bigint_t, which is freed again as soon as a
+  // temporary goes away.  Rather than return these to malloc, freed
+  // objects are kept on a list and handed out again.  Each thread has
+  // its own list, since reports may sum amounts on several threads; an
+  // object freed on another thread than the one that allocated it is
+  // still an ordinary malloc block, so it may join either list.
+  struct free_block_t {
+    free_block_t * next;
+  };
+
+  struct bigint_pool_t {
+    free_block_t * head;
+
+    ~bigint_pool_t();
+  };
+
+  thread_local bigint_pool_t bigint_pool;
+  thread_local bool          bigint_pool_closed = false;
+
+  bigint_pool_t::~bigint_pool_t()
+  {
+    while (free_block_t * block = head) {
+      head = block->next;
+      std::free(block);
+    }
+    // Objects freed while the thread is exiting go straight to free().
+    bigint_pool_closed = true;
+  }
+}
+
+void * amount_t::bigint_t::operator new(std::size_t size)
+{
+  assert(size == sizeof(bigint_t));
+  if (free_block_t * block = bigint_pool.head) {
+    bigint_pool.head = block->next;
+    return block;
+  }
+  if (void * ptr = std::malloc(std::max(size, sizeof(free_block_t))))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void amount_t::bigint_t::operator delete(void * ptr, std::size_t)
+{
+  if (! is_initialized || bigint_pool_closed) {
+    std::free(ptr);
+  } else {
+    free_block_t * block = static_cast<free_block_t *>(ptr);
+    block->next      = bigint_pool.head;
+    bigint_pool.head = block;
+  }
+}
+
+namespace {
+  // Only the address of this is used, to mark inline quantities.
+  char inline_quantity_tag;
+}
+
+amount_t::bigint_t * const amount_t::inline_quantity =
+  reinterpret_cast<amount_t::bigint_t *>(&inline_quantity_tag);
+
+namespace {
+  const uint_least8_t inline_max_scale = 18;
+
+  const int_least64_t inline_pow10[inline_max_scale + 1] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+    100000000LL, 1000000000LL, 10000000000LL, 100000000000LL,
+    1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+    1000000000000000000LL
+  };
+
+  // Each of these returns false if the result would not fit, in which
+  // case the caller falls back to GMP.
+  inline bool inline_add(int_least64_t a, int_least64_t b, int_least64_t& r)
+  {
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+    return ! __builtin_add_overflow(a, b, &r);
+#else
+    if ((b > 0 && a > INT_LEAST64_MAX - b) ||
+        (b < 0 && a < INT_LEAST64_MIN - b))
+      return false;
+    r = a + b;
+    return true;
+#endif
+  }
+
+  inline bool inline_sub(int_least64_t a, int_least64_t b, int_least64_t& r)
+  {
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+    return ! __builtin_sub_overflow(a, b, &r);
+#else
+    if ((b < 0 && a > INT_LEAST64_MAX + b) ||
+        (b > 0 && a < INT_LEAST64_MIN + b))
+      return false;
+    r = a - b;
+    return true;
+#endif
+  }
+
+  inline bool inline_mul(int_least64_t a, int_least64_t b, int_least64_t& r)
+  {
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+    return ! __builtin_mul_overflow(a, b, &r);
+#else
+    if (a > 0 ? (b > 0 ? a > INT_LEAST64_MAX / b : b < INT_LEAST64_MIN / a) :
+        (b > 0 ? a < INT_LEAST64_MIN / b :
+         (a != 0 && b < INT_LEAST64_MAX / a)))
+      return false;
+    r = a * b;
+    return true;
+#endif
+  }
+
+  // Express `num', held at `scale' decimal places, at `to' places.
+  inline bool inline_rescale(int_least64_t num, uint_least8_t scale,
+                             uint_least8_t to, int_least64_t& r)
+  {
+    assert(to >= scale && to <= inline_max_scale);
+    return inline_mul(num, inline_pow10[to - scale], r);
+  }
+
+  void set_mpz_int64(mpz_t dest, int_least64_t val)
+  {
+    if (sizeof(long) >= sizeof(int_least64_t)) {
+      mpz_set_si(dest, static_cast<long>(val));
+    } else {
+      uint_least64_t mag = val < 0 ?
+        uint_least64_t(0) - static_cast<uint_least64_t>(val) :
+        static_cast<uint_least64_t>(val);
+      mpz_import(dest, 1, -1, sizeof(mag), 0, 0, &mag);
+      if (val < 0)
+        mpz_neg(dest, dest);
+    }
+  }
+
+  void set_mpq_inline(mpq_t dest, int_least64_t num, uint_least8_t scale)
+  {
+    set_mpz_int64(mpq_numref(dest), num);
+    set_mpz_int64(mpq_denref(dest), inline_pow10[scale]);
+    mpq_canonicalize(dest);
+  }
+}
+
 namespace {
   void stream_out_mpq(std::ostream&                 out,
-                      mpq_t                         quant,
+                      mpq_srcptr                    quant,
                       amount_t::precision_t         precision,
                       int                           zeros_prec = -1,
                       mpfr_rnd_t                    rnd        = GMP_RNDN,
@@ -229,6 +379,8 @@ void amount_t::initialize()
   if (! is_initialized) {
     mpz_init(temp);
     mpq_init(tempq);
+    mpq_init(tempqa);
+    mpq_init(tempqb);
     mpfr_init(tempf);
     mpfr_init(tempfb);
     mpfr_init(tempfnum);
@@ -262,6 +414,8 @@ void amount_t::shutdown()
   if (is_initialized) {
     mpz_clear(temp);
     mpq_clear(tempq);
+    mpq_clear(tempqa);
+    mpq_clear(tempqb);
     mpfr_clear(tempf);
     mpfr_clear(tempfb);
     mpfr_clear(tempfnum);
@@ -277,6 +431,13 @@ void amount_t::_copy(const amount_t& amt)
 {
   VERIFY(amt.valid());
 
+  if (amt._is_inline()) {
+    if (quantity && ! _is_inline())
+      _release();
+    _copy_inline(amt);
+    return;
+  }
+
   if (quantity != amt.quantity) {
     if (quantity)
       _release();
@@ -301,6 +462,9 @@ void amount_t::_dup()
 {
   VERIFY(valid());
 
+  if (_is_inline())
+    return;
+
   if (quantity->refc > 1) {
     bigint_t * q = new bigint_t(*quantity);
     _release();
@@ -325,6 +489,12 @@ void amount_t::_release()
 {
   VERIFY(valid());
 
+  if (_is_inline()) {
+    quantity   = NULL;
+    commodity_ = NULL;
+    return;
+  }
+
   DEBUG("amount.refs", quantity << " refc--, now " << (quantity->refc - 1));
 
   if (--quantity->refc == 0) {
@@ -340,6 +510,38 @@ void amount_t::_release()
 }
 
 
+void amount_t::_promote()
+{
+  if (! _is_inline())
+    return;
+
+  bigint_t * q = new bigint_t;
+  set_mpq_inline(MP(q), inline_num, inline_scale);
+  q->prec = inline_prec;
+  if (inline_keep_prec)
+    q->add_flags(BIGINT_KEEP_PREC);
+  quantity = q;
+}
+
+namespace {
+  inline mpq_srcptr inline_mpq(mpq_t scratch, int_least64_t num,
+                               uint_least8_t scale)
+  {
+    set_mpq_inline(scratch, num, scale);
+    return scratch;
+  }
+}
+
+// The exact value of an amount as a GMP rational.  Inline quantities are
+// converted into `scratch', which must not be in use by the caller.
+#define MPQ(amt, scratch)                                               \
+  ((amt)._is_inline() ?                                                 \
+   inline_mpq(scratch, (amt).inline_num, (amt).inline_scale) :          \
+   static_cast<mpq_srcptr>(MP((amt).quantity)))
+
+#define PREC(amt)                                                       \
+  ((amt)._is_inline() ? (amt).inline_prec : (amt).quantity->prec)
+
 amount_t::amount_t(const double val) : commodity_(NULL)
 {
   quantity = new bigint_t;
@@ -350,15 +552,27 @@ amount_t::amount_t(const double val) : commodity_(NULL)
 
 amount_t::amount_t(const unsigned long val) : commodity_(NULL)
 {
-  quantity = new bigint_t;
-  mpq_set_ui(MP(quantity), val, 1);
+  if (static_cast<uint_least64_t>(val) <=
+      static_cast<uint_least64_t>(INT_LEAST64_MAX)) {
+    quantity         = inline_quantity;
+    inline_num       = static_cast<int_least64_t>(val);
+    inline_prec      = 0;
+    inline_scale     = 0;
+    inline_keep_prec = false;
+  } else {
+    quantity = new bigint_t;
+    mpq_set_ui(MP(quantity), val, 1);
+  }
   TRACE_CTOR(amount_t, "const unsigned long");
 }
 
 amount_t::amount_t(const long val) : commodity_(NULL)
 {
-  quantity = new bigint_t;
-  mpq_set_si(MP(quantity), val, 1);
+  quantity         = inline_quantity;
+  inline_num       = val;
+  inline_prec      = 0;
+  inline_scale     = 0;
+  inline_keep_prec = false;
   TRACE_CTOR(amount_t, "const long");
 }
 
@@ -394,7 +608,15 @@ int amount_t::compare(const amount_t& amt) const
            % commodity() % amt.commodity());
   }
 
-  return mpq_cmp(MP(quantity), MP(amt.quantity));
+  if (_is_inline() && amt._is_inline()) {
+    uint_least8_t scale = std::max(inline_scale, amt.inline_scale);
+    int_least64_t a, b;
+    if (inline_rescale(inline_num, inline_scale, scale, a) &&
+        inline_rescale(amt.inline_num, amt.inline_scale, scale, b))
+      return a < b ? -1 : (a > b ? 1 : 0);
+  }
+
+  return mpq_cmp(MPQ(*this, tempqa), MPQ(amt, tempqb));
 }
 
 bool amount_t::operator==(const amount_t& amt) const
@@ -406,10 +628,45 @@ bool amount_t::operator==(const amount_t& amt) const
   else if (commodity() != amt.commodity())
     return false;
 
-  return mpq_equal(MP(quantity), MP(amt.quantity));
+  if (_is_inline() && amt._is_inline()) {
+    uint_least8_t scale = std::max(inline_scale, amt.inline_scale);
+    int_least64_t a, b;
+    if (inline_rescale(inline_num, inline_scale, scale, a) &&
+        inline_rescale(amt.inline_num, amt.inline_scale, scale, b))
+      return a == b;
+  }
+
+  return mpq_equal(MPQ(*this, tempqa), MPQ(amt, tempqb));
 }
 
 
+bool amount_t::add_inline(const amount_t& amt)
+{
+  if (! amt._is_inline())
+    return false;
+  if (! quantity) {
+    _copy_inline(amt);
+    return true;
+  }
+  if (! _is_inline() ||
+      (has_commodity() && amt.has_commodity() && commodity() != amt.commodity()))
+    return false;
+
+  uint_least8_t scale = std::max(inline_scale, amt.inline_scale);
+  int_least64_t a, b, r;
+  if (! (inline_rescale(inline_num, inline_scale, scale, a) &&
+         inline_rescale(amt.inline_num, amt.inline_scale, scale, b) &&
+         inline_add(a, b, r)))
+    return false;
+
+  inline_num   = r;
+  inline_scale = scale;
+  if (has_commodity() == amt.has_commodity())
+    if (inline_prec < amt.inline_prec)
+      inline_prec = amt.inline_prec;
+  return true;
+}
+
 amount_t& amount_t::operator+=(const amount_t& amt)
 {
   VERIFY(amt.valid());
@@ -429,13 +686,17 @@ amount_t& amount_t::operator+=(const amount_t& amt)
            % commodity() % amt.commodity());
   }
 
+  if (add_inline(amt))
+    return *this;
+
+  _promote();
   _dup();
 
-  mpq_add(MP(quantity), MP(quantity), MP(amt.quantity));
+  mpq_add(MP(quantity), MP(quantity), MPQ(amt, tempqb));
 
   if (has_commodity() == amt.has_commodity())
-    if (quantity->prec < amt.quantity->prec)
-      quantity->prec = amt.quantity->prec;
+    if (quantity->prec < PREC(amt))
+      quantity->prec = PREC(amt);
 
   return *this;
 }
@@ -459,13 +720,29 @@ amount_t& amount_t::operator-=(const amount_t& amt)
            % commodity() % amt.commodity());
   }
 
+  if (_is_inline() && amt._is_inline()) {
+    uint_least8_t scale = std::max(inline_scale, amt.inline_scale);
+    int_least64_t a, b, r;
+    if (inline_rescale(inline_num, inline_scale, scale, a) &&
+        inline_rescale(amt.inline_num, amt.inline_scale, scale, b) &&
+        inline_sub(a, b, r)) {
+      inline_num   = r;
+      inline_scale = scale;
+      if (has_commodity() == amt.has_commodity())
+        if (inline_prec < amt.inline_prec)
+          inline_prec = amt.inline_prec;
+      return *this;
+    }
+  }
+
+  _promote();
   _dup();
 
-  mpq_sub(MP(quantity), MP(quantity), MP(amt.quantity));
+  mpq_sub(MP(quantity), MP(quantity), MPQ(amt, tempqb));
 
   if (has_commodity() == amt.has_commodity())
-    if (quantity->prec < amt.quantity->prec)
-      quantity->prec = amt.quantity->prec;
+    if (quantity->prec < PREC(amt))
+      quantity->prec = PREC(amt);
 
   return *this;
 }
@@ -483,19 +760,35 @@ amount_t& amount_t::multiply(const amount_t& amt, bool ignore_commodity)
       throw_(amount_error, _("Cannot multiply two uninitialized amounts"));
   }
 
-  _dup();
+  int_least64_t r;
+  if (_is_inline() && amt._is_inline() &&
+      inline_scale + amt.inline_scale <= inline_max_scale &&
+      inline_mul(inline_num, amt.inline_num, r)) {
+    inline_num   = r;
+    inline_scale = static_cast<uint_least8_t>(inline_scale +
+                                              amt.inline_scale);
+    inline_prec  = static_cast<precision_t>(inline_prec + amt.inline_prec);
+  } else {
+    _promote();
+    _dup();
 
-  mpq_mul(MP(quantity), MP(quantity), MP(amt.quantity));
-  quantity->prec =
-    static_cast<precision_t>(quantity->prec + amt.quantity->prec);
+    mpq_mul(MP(quantity), MP(quantity), MPQ(amt, tempqb));
+    quantity->prec =
+      static_cast<precision_t>(quantity->prec + PREC(amt));
+  }
 
   if (! has_commodity() && ! ignore_commodity)
     commodity_ = amt.commodity_;
 
   if (has_commodity() && ! keep_precision()) {
     precision_t comm_prec = commodity().precision();
-    if (quantity->prec > comm_prec + extend_by_digits)
-      quantity->prec = static_cast<precision_t>(comm_prec + extend_by_digits);
+    if (PREC(*this) > comm_prec + extend_by_digits) {
+      precision_t prec = static_cast<precision_t>(comm_prec + extend_by_digits);
+      if (_is_inline())
+        inline_prec = prec;
+      else
+        quantity->prec = prec;
+    }
   }
 
   return *this;
@@ -517,15 +810,40 @@ amount_t& amount_t::operator/=(const amount_t& amt)
   if (! amt)
     throw_(amount_error, _("Divide by zero"));
 
-  _dup();
-
   // Increase the value's precision, to capture fractional parts after
   // the divide.  Round up in the last position.
 
-  mpq_div(MP(quantity), MP(quantity), MP(amt.quantity));
-  quantity->prec =
-    static_cast<precision_t>(quantity->prec + amt.quantity->prec +
-                             extend_by_digits);
+  precision_t prec =
+    static_cast<precision_t>(PREC(*this) + PREC(amt) + extend_by_digits);
+
+  bool divided = false;
+  if (_is_inline() && amt._is_inline()) {
+    // Look for the smallest scale at which the quotient is exact.
+    for (uint_least8_t scale = 0; scale <= inline_max_scale; ++scale) {
+      int_least64_t num = inline_num, den = amt.inline_num;
+      int up = scale + amt.inline_scale - inline_scale;
+      if (up > inline_max_scale ||
+          (up > 0 && ! inline_mul(num, inline_pow10[up], num)) ||
+          (up < 0 && ! inline_mul(den, inline_pow10[-up], den)))
+        break;
+      if (den == -1 && num == INT_LEAST64_MIN)
+        break;
+      if (num % den == 0) {
+        inline_num   = num / den;
+        inline_scale = scale;
+        inline_prec  = prec;
+        divided      = true;
+        break;
+      }
+    }
+  }
+
+  if (! divided) {
+    _promote();
+    _dup();
+    mpq_div(MP(quantity), MP(quantity), MPQ(amt, tempqb));
+    quantity->prec = prec;
+  }
 
   if (! has_commodity())
     commodity_ = amt.commodity_;
@@ -537,8 +855,13 @@ amount_t& amount_t::operator/=(const amount_t& amt)
 
   if (has_commodity() && ! keep_precision()) {
     precision_t comm_prec = commodity().precision();
-    if (quantity->prec > comm_prec + extend_by_digits)
-      quantity->prec = static_cast<precision_t>(comm_prec + extend_by_digits);
+    if (PREC(*this) > comm_prec + extend_by_digits) {
+      prec = static_cast<precision_t>(comm_prec + extend_by_digits);
+      if (_is_inline())
+        inline_prec = prec;
+      else
+        quantity->prec = prec;
+    }
   }
 
   return *this;
@@ -550,7 +873,7 @@ amount_t::precision_t amount_t::precision() const
     throw_(amount_error,
            _("Cannot determine precision of an uninitialized amount"));
 
-  return quantity->prec;
+  return PREC(*this);
 }
 
 bool amount_t::keep_precision() const
@@ -559,6 +882,8 @@ bool amount_t::keep_precision() const
     throw_(amount_error,
            _("Cannot determine if precision of an uninitialized amount is kept"));
 
+  if (_is_inline())
+    return inline_keep_prec;
   return quantity->has_flags(BIGINT_KEEP_PREC);
 }
 
@@ -568,7 +893,9 @@ void amount_t::set_keep_precision(const bool keep) const
     throw_(amount_error,
            _("Cannot set whether to keep the precision of an uninitialized amount"));
 
-  if (keep)
+  if (_is_inline())
+    inline_keep_prec = keep;
+  else if (keep)
     quantity->add_flags(BIGINT_KEEP_PREC);
   else
     quantity->drop_flags(BIGINT_KEEP_PREC);
@@ -585,12 +912,19 @@ amount_t::precision_t amount_t::display_precision() const
   if (comm && ! keep_precision())
     return comm.precision();
   else
-    return comm ? std::max(quantity->prec, comm.precision()) : quantity->prec;
+    return comm ? std::max(PREC(*this), comm.precision()) : PREC(*this);
 }
 
 void amount_t::in_place_negate()
 {
   if (quantity) {
+    if (_is_inline()) {
+      if (inline_num != INT_LEAST64_MIN) {
+        inline_num = -inline_num;
+        return;
+      }
+      _promote();
+    }
     _dup();
     mpq_neg(MP(quantity), MP(quantity));
   } else {
@@ -603,6 +937,7 @@ void amount_t::in_place_invert()
   if (! quantity)
     throw_(amount_error, _("Cannot invert an uninitialized amount"));
 
+  _promote();
   _dup();
   mpq_inv(MP(quantity), MP(quantity));
 }
@@ -624,6 +959,7 @@ void amount_t::in_place_truncate()
   if (! quantity)
     throw_(amount_error, _("Cannot truncate an uninitialized amount"));
 
+  _promote();
   _dup();
 
   DEBUG("amount.truncate",
@@ -661,6 +997,7 @@ void amount_t::in_place_floor()
   if (! quantity)
     throw_(amount_error, _("Cannot compute floor on an uninitialized amount"));
 
+  _promote();
   _dup();
 
   mpz_fdiv_q(temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
@@ -672,6 +1009,7 @@ void amount_t::in_place_ceiling()
   if (! quantity)
     throw_(amount_error, _("Cannot compute ceiling on an uninitialized amount"));
 
+  _promote();
   _dup();
 
   mpz_cdiv_q(temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
@@ -682,8 +1020,49 @@ void amount_t::in_place_roundto(int places)
 {
   if (! quantity)
     throw_(amount_error, _("Cannot round an uninitialized amount"));
-    double x=ceil(mpq_get_d(MP(quantity))*pow(10, places) - 0.49999999) / pow(10, places);
-    mpq_set_d(MP(quantity), x);
+
+  if (_is_inline() && places >= 0 && places <= inline_max_scale) {
+    // Halves round upwards, exactly as they do below.
+    if (places < inline_scale) {
+      int_least64_t div = inline_pow10[inline_scale - places];
+      int_least64_t q   = inline_num / div;
+      int_least64_t r   = inline_num % div;
+      if (r < 0) {
+        q--;
+        r += div;
+      }
+      if (r >= div - r)
+        q++;
+      inline_num   = q;
+      inline_scale = static_cast<uint_least8_t>(places);
+    }
+    return;
+  }
+
+  _promote();
+  _dup();
+
+  // Scale by 10^places and take floor(x + 1/2) = floor((2n + d) / 2d)
+  mpz_ui_pow_ui(temp, 10, static_cast<unsigned long>(std::abs(places)));
+  mpq_set(tempq, MP(quantity));
+  if (places >= 0)
+    mpz_mul(mpq_numref(tempq), mpq_numref(tempq), temp);
+  else
+    mpz_mul(mpq_denref(tempq), mpq_denref(tempq), temp);
+
+  mpz_mul_2exp(mpq_numref(tempq), mpq_numref(tempq), 1);
+  mpz_add(mpq_numref(tempq), mpq_numref(tempq), mpq_denref(tempq));
+  mpz_mul_2exp(mpq_denref(tempq), mpq_denref(tempq), 1);
+  mpz_fdiv_q(mpq_numref(tempq), mpq_numref(tempq), mpq_denref(tempq));
+
+  if (places >= 0) {
+    mpz_set(mpq_denref(tempq), temp);
+  } else {
+    mpz_mul(mpq_numref(tempq), mpq_numref(tempq), temp);
+    mpz_set_ui(mpq_denref(tempq), 1);
+  }
+  mpq_canonicalize(tempq);
+  mpq_set(MP(quantity), tempq);
 }
 
 void amount_t::in_place_unround()
@@ -822,6 +1201,8 @@ int amount_t::sign() const
   if (! quantity)
     throw_(amount_error, _("Cannot determine sign of an uninitialized amount"));
 
+  if (_is_inline())
+    return inline_num < 0 ? -1 : (inline_num > 0 ? 1 : 0);
   return mpq_sgn(MP(quantity));
 }
 
@@ -831,13 +1212,15 @@ bool amount_t::is_zero() const
     throw_(amount_error, _("Cannot determine if an uninitialized amount is zero"));
 
   if (has_commodity()) {
-    if (keep_precision() || quantity->prec <= commodity().precision()) {
+    if (keep_precision() || PREC(*this) <= commodity().precision()) {
       return is_realzero();
     }
     else if (is_realzero()) {
       return true;
     }
-    else if (mpz_cmp(mpq_numref(MP(quantity)),
+    else if (_is_inline() ?
+             inline_num > inline_pow10[inline_scale] :
+             mpz_cmp(mpq_numref(MP(quantity)),
                      mpq_denref(MP(quantity))) > 0) {
       DEBUG("amount.is_zero", "Numerator is larger than the denominator");
       return false;
@@ -846,7 +1229,7 @@ bool amount_t::is_zero() const
       DEBUG("amount.is_zero", "We have to print the number to check for zero");
 
       std::ostringstream out;
-      stream_out_mpq(out, MP(quantity), commodity().precision());
+      stream_out_mpq(out, MPQ(*this, tempqa), commodity().precision());
 
       string output = out.str();
       if (! output.empty()) {
@@ -866,7 +1249,7 @@ double amount_t::to_double() const
   if (! quantity)
     throw_(amount_error, _("Cannot convert an uninitialized amount to a double"));
 
-  mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
+  mpfr_set_q(tempf, MPQ(*this, tempqa), GMP_RNDN);
   return mpfr_get_d(tempf, GMP_RNDN);
 }
 
@@ -875,16 +1258,25 @@ long amount_t::to_long() const
   if (! quantity)
     throw_(amount_error, _("Cannot convert an uninitialized amount to a long"));
 
-  mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
+  mpfr_set_q(tempf, MPQ(*this, tempqa), GMP_RNDN);
   return mpfr_get_si(tempf, GMP_RNDN);
 }
 
 bool amount_t::fits_in_long() const
 {
-  mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
+  mpfr_set_q(tempf, MPQ(*this, tempqa), GMP_RNDN);
   return mpfr_fits_slong_p(tempf, GMP_RNDN);
 }
 
+bool amount_t::to_fixed_point(int_least64_t& num, uint_least8_t& scale) const
+{
+  if (! _is_inline())
+    return false;
+  num   = inline_num;
+  scale = inline_scale;
+  return true;
+}
+
 commodity_t * amount_t::commodity_ptr() const
 {
   return (commodity_ ?
@@ -1055,19 +1447,16 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
   unique_ptr<bigint_t> new_quantity;
 
   if (quantity) {
-    if (quantity->refc > 1)
+    if (_is_inline() || quantity->refc > 1) {
       _release();
-    else
+    } else {
       new_quantity.reset(quantity);
+      // No one is holding a reference to this now.
+      new_quantity->refc--;
+    }
     quantity = NULL;
   }
 
-  if (! new_quantity.get())
-    new_quantity.reset(new bigint_t);
-
-  // No one is holding a reference to this now.
-  new_quantity->refc--;
-
   // Create the commodity if has not already been seen, and update the
   // precision if something greater was used for the quantity.
 
@@ -1101,7 +1490,8 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
        commodity().has_flags(COMMODITY_STYLE_TIME_COLON));
 #endif
 
-  new_quantity->prec = 0;
+  precision_t prec      = 0;
+  bool        keep_prec = false;
 
   BOOST_REVERSE_FOREACH (const char& ch, quant) {
     string_index--;
@@ -1122,7 +1512,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
             throw_(amount_error, _("Incorrect use of thousand-mark period"));
         } else {
           no_more_periods    = true;
-          new_quantity->prec = decimal_offset;
+          prec               = decimal_offset;
           decimal_offset     = 0;
         }
       }
@@ -1139,7 +1529,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
           throw_(amount_error, _("Incorrect use of decimal comma"));
         } else {
           no_more_commas     = true;
-          new_quantity->prec = decimal_offset;
+          prec               = decimal_offset;
           decimal_offset     = 0;
         }
       } else {
@@ -1150,7 +1540,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
           } else {
             decimal_comma_style = true;
             no_more_commas      = true;
-            new_quantity->prec  = decimal_offset;
+            prec                = decimal_offset;
             decimal_offset      = 0;
           }
         } else {
@@ -1171,51 +1561,81 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
     comm_flags |= COMMODITY_STYLE_DECIMAL_COMMA;
 
   if (flags.has_flags(PARSE_NO_MIGRATE)) {
-    // Can't call set_keep_precision here, because it assumes that `quantity'
-    // is non-NULL.
-    new_quantity->add_flags(BIGINT_KEEP_PREC);
+    // Can't call set_keep_precision here, because `quantity' has not
+    // been set yet.
+    keep_prec = true;
   }
   else if (commodity_ && ! no_migrate_style) {
     commodity().add_flags(comm_flags);
 
-    if (new_quantity->prec > commodity().precision())
-      commodity().set_precision(new_quantity->prec);
+    if (prec > commodity().precision())
+      commodity().set_precision(prec);
   }
 
   // Now we have the final number.  Remove commas and periods, if necessary.
 
-  if (last_comma != string::npos || last_period != string::npos) {
-    string::size_type  len = quant.length();
-    scoped_array<char> buf(new char[len + 1]);
-    const char *       p   = quant.c_str();
-    char *             t   = buf.get();
-
-    while (*p) {
-      if (*p == ',' || *p == '.')
-        p++;
-      *t++ = *p++;
+  string::size_type  len = quant.length();
+  scoped_array<char> buf(new char[len + 1]);
+  const char *       p   = quant.c_str();
+  char *             t   = buf.get();
+  bool               all_digits = true;
+
+  while (*p) {
+    if (*p == ',' || *p == '.')
+      p++;
+    if (! std::isdigit(static_cast<unsigned char>(*p)))
+      all_digits = false;
+    *t++ = *p++;
+  }
+  *t = '\0';
+
+  // Anything with at most 18 digits fits in 64 bits, and can be held
+  // inline without calling into GMP at all.
+  len = static_cast<string::size_type>(t - buf.get());
+  if (all_digits && len > 0 && len <= inline_max_scale &&
+      prec <= inline_max_scale) {
+    int_least64_t num = 0;
+    for (const char * d = buf.get(); *d; d++)
+      num = num * 10 + (*d - '0');
+
+    quantity         = inline_quantity;
+    inline_num       = negative ? -num : num;
+    inline_prec      = prec;
+    inline_scale     = static_cast<uint_least8_t>(prec);
+    inline_keep_prec = keep_prec;
+
+    DEBUG("amount.parse", "Inline parsed = " << inline_num
+          << " / 10^" << int(inline_scale));
+  } else {
+    if (! new_quantity.get()) {
+      new_quantity.reset(new bigint_t);
+      new_quantity->refc--;
     }
-    *t = '\0';
+    new_quantity->prec = prec;
+    if (keep_prec)
+      new_quantity->add_flags(BIGINT_KEEP_PREC);
+    else
+      new_quantity->drop_flags(BIGINT_KEEP_PREC);
 
     mpq_set_str(MP(new_quantity.get()), buf.get(), 10);
-    mpz_ui_pow_ui(temp, 10, new_quantity->prec);
-    mpq_set_z(tempq, temp);
-    mpq_div(MP(new_quantity.get()), MP(new_quantity.get()), tempq);
+    if (prec > 0) {
+      mpz_ui_pow_ui(temp, 10, prec);
+      mpq_set_z(tempq, temp);
+      mpq_div(MP(new_quantity.get()), MP(new_quantity.get()), tempq);
+    }
 
     IF_DEBUG("amount.parse") {
       char * amt_buf = mpq_get_str(NULL, 10, MP(new_quantity.get()));
       DEBUG("amount.parse", "Rational parsed = " << amt_buf);
       std::free(amt_buf);
     }
-  } else {
-    mpq_set_str(MP(new_quantity.get()), quant.c_str(), 10);
-  }
 
-  if (negative)
-    mpq_neg(MP(new_quantity.get()), MP(new_quantity.get()));
+    if (negative)
+      mpq_neg(MP(new_quantity.get()), MP(new_quantity.get()));
 
-  new_quantity->refc++;
-  quantity = new_quantity.release();
+    new_quantity->refc++;
+    quantity = new_quantity.release();
+  }
 
   if (! flags.has_flags(PARSE_NO_REDUCE))
     in_place_reduce();          // will not throw an exception
@@ -1271,7 +1691,7 @@ void amount_t::print(std::ostream& _out, const uint_least8_t flags) const
       out << " ";
   }
 
-  stream_out_mpq(out, MP(quantity), display_precision(),
+  stream_out_mpq(out, MPQ(*this, tempqa), display_precision(),
                  comm ? commodity().precision() : 0, GMP_RNDN, comm);
 
   if (comm.has_flags(COMMODITY_STYLE_SUFFIXED)) {
@@ -1290,9 +1710,151 @@ void amount_t::print(std::ostream& _out, const uint_least8_t flags) const
   _out << out.str();
 }
 
+namespace {
+  typedef uint_least64_t quantity_word_t;
+
+  void write_mpz(string& buffer, mpz_t value)
+  {
+    std::size_t    offset = buffer.length() + sizeof(uint_least32_t);
+    std::size_t    words  = (mpz_sizeinbase(value, 2) + 63) / 64;
+    std::size_t    count  = 0;
+
+    buffer.resize(offset + words * sizeof(quantity_word_t));
+    mpz_export(&buffer[offset], &count, -1, sizeof(quantity_word_t), 0, 0,
+               value);
+    buffer.resize(offset + count * sizeof(quantity_word_t));
+
+    uint_least32_t len = static_cast<uint_least32_t>(count);
+    std::memcpy(&buffer[offset - sizeof(len)], &len, sizeof(len));
+  }
+
+  const char * read_mpz(mpz_t value, const char * p, const char * end)
+  {
+    uint_least32_t count;
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(count)))
+      return NULL;
+    std::memcpy(&count, p, sizeof(count));
+    p += sizeof(count);
+
+    if (static_cast<std::size_t>(end - p) / sizeof(quantity_word_t) < count)
+      return NULL;
+    mpz_import(value, count, -1, sizeof(quantity_word_t), 0, 0, p);
+    return p + count * sizeof(quantity_word_t);
+  }
+}
+
+void amount_t::write_quantity(string& buffer) const
+{
+  VERIFY(valid());
+
+#define QUANTITY_PRESENT   0x01
+#define QUANTITY_KEEP_PREC 0x02
+#define QUANTITY_NEGATIVE  0x04
+#define QUANTITY_INLINE    0x08
+
+  if (! quantity) {
+    buffer.push_back('\0');
+    return;
+  }
+
+  if (_is_inline()) {
+    uint_least8_t  flags = QUANTITY_PRESENT | QUANTITY_INLINE;
+    if (inline_keep_prec)
+      flags |= QUANTITY_KEEP_PREC;
+    uint_least16_t prec = inline_prec;
+    buffer.push_back(static_cast<char>(flags));
+    buffer.append(reinterpret_cast<const char *>(&prec), sizeof(prec));
+    buffer.append(reinterpret_cast<const char *>(&inline_num),
+                  sizeof(inline_num));
+    buffer.push_back(static_cast<char>(inline_scale));
+    return;
+  }
+
+  // The numerator and denominator are stored as raw machine words, which
+  // is both exact and far cheaper to restore than a textual form.
+  uint_least8_t flags = QUANTITY_PRESENT;
+  if (quantity->has_flags(BIGINT_KEEP_PREC))
+    flags |= QUANTITY_KEEP_PREC;
+  if (mpq_sgn(MP(quantity)) < 0)
+    flags |= QUANTITY_NEGATIVE;
+
+  uint_least16_t prec = quantity->prec;
+  buffer.push_back(static_cast<char>(flags));
+  buffer.append(reinterpret_cast<const char *>(&prec), sizeof(prec));
+
+  write_mpz(buffer, mpq_numref(MP(quantity)));
+  write_mpz(buffer, mpq_denref(MP(quantity)));
+}
+
+std::size_t amount_t::read_quantity(const char * data, const std::size_t len)
+{
+  _clear();
+
+  const char * p   = data;
+  const char * end = data + len;
+
+  if (p == end)
+    throw_(amount_error, _("Truncated amount quantity"));
+
+  uint_least8_t flags = static_cast<uint_least8_t>(*p++);
+  if (! (flags & QUANTITY_PRESENT))
+    return 1;
+
+  uint_least16_t prec;
+  if (end - p < static_cast<std::ptrdiff_t>(sizeof(prec)))
+    throw_(amount_error, _("Truncated amount quantity"));
+  std::memcpy(&prec, p, sizeof(prec));
+  p += sizeof(prec);
+
+  if (flags & QUANTITY_INLINE) {
+    int_least64_t num;
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(num) + 1))
+      throw_(amount_error, _("Truncated amount quantity"));
+    std::memcpy(&num, p, sizeof(num));
+    p += sizeof(num);
+    uint_least8_t scale = static_cast<uint_least8_t>(*p++);
+    if (scale > inline_max_scale)
+      throw_(amount_error, _("Invalid amount quantity"));
+
+    quantity         = inline_quantity;
+    inline_num       = num;
+    inline_prec      = static_cast<precision_t>(prec);
+    inline_scale     = scale;
+    inline_keep_prec = flags & QUANTITY_KEEP_PREC;
+    return static_cast<std::size_t>(p - data);
+  }
+
+  quantity = new bigint_t;
+  quantity->prec = prec;
+  if (flags & QUANTITY_KEEP_PREC)
+    quantity->add_flags(BIGINT_KEEP_PREC);
+
+  if (! (p = read_mpz(mpq_numref(MP(quantity)), p, end)) ||
+      ! (p = read_mpz(mpq_denref(MP(quantity)), p, end))) {
+    _release();
+    throw_(amount_error, _("Truncated amount quantity"));
+  }
+  if (mpz_sgn(mpq_denref(MP(quantity))) == 0) {
+    _release();
+    throw_(amount_error, _("Invalid amount quantity"));
+  }
+  if (flags & QUANTITY_NEGATIVE)
+    mpq_neg(MP(quantity), MP(quantity));
+
+  VERIFY(valid());
+
+  return static_cast<std::size_t>(p - data);
+}
+
 bool amount_t::valid() const
 {
-  if (quantity) {
+  if (_is_inline()) {
+    if (inline_scale > inline_max_scale) {
+      DEBUG("ledger.validate", "amount_t: inline_scale > inline_max_scale");
+      return false;
+    }
+  }
+  else if (quantity) {
     if (! quantity->valid()) {
       DEBUG("ledger.validate", "amount_t: ! quantity->valid()");
       return false;
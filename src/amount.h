@@ -122,11 +122,35 @@ protected:
   void _dup();
   void _clear();
   void _release();
+  void _promote();
 
   struct bigint_t;
 
-  bigint_t *    quantity;
-  commodity_t * commodity_;
+  /** Most quantities are short decimals such as $12.34.  These are held
+      inline, as inline_num / 10^inline_scale, and only moved into a
+      bigint_t when an operation would overflow 64 bits.  `quantity' then
+      points at `inline_quantity', so that testing it for NULL still says
+      whether the amount has a value. */
+  static bigint_t * const inline_quantity;
+
+  bigint_t *     quantity;
+  commodity_t *  commodity_;
+  int_least64_t  inline_num;
+  precision_t    inline_prec;
+  uint_least8_t  inline_scale;
+  mutable bool   inline_keep_prec;
+
+  bool _is_inline() const {
+    return quantity == inline_quantity;
+  }
+  void _copy_inline(const amount_t& amt) {
+    quantity         = inline_quantity;
+    commodity_       = amt.commodity_;
+    inline_num       = amt.inline_num;
+    inline_prec      = amt.inline_prec;
+    inline_scale     = amt.inline_scale;
+    inline_keep_prec = amt.inline_keep_prec;
+  }
 
 public:
   /** @name Constructors
@@ -183,7 +207,7 @@ public:
       amount_t::bigint_t object. */
   ~amount_t() {
     TRACE_DTOR(amount_t);
-    if (quantity)
+    if (quantity && ! _is_inline())
       _release();
   }
 
@@ -195,7 +219,9 @@ public:
       same memory used by the original via reference counting.  The \c
       amount_t::bigint_t class in amount.cc maintains the reference. */
   amount_t(const amount_t& amt) : quantity(NULL) {
-    if (amt.quantity)
+    if (amt._is_inline())
+      _copy_inline(amt);
+    else if (amt.quantity)
       _copy(amt);
     else
       commodity_ = NULL;
@@ -274,6 +300,14 @@ public:
 
   amount_t& operator+=(const amount_t& amt);
   amount_t& operator-=(const amount_t& amt);
+
+  /** Add `amt' only if it and this amount are held inline, have
+      compatible commodities and their sum still fits in 64 bits,
+      returning whether it was added.  A null amount simply becomes a
+      copy of `amt'.  Unlike operator+=, this never touches GMP's shared
+      temporaries, so several threads may call it at once on different
+      amounts. */
+  bool add_inline(const amount_t& amt);
   amount_t& operator*=(const amount_t& amt) {
     return multiply(amt);
   }
@@ -499,6 +533,11 @@ public:
       fits_in_long() returns true if to_long() would not lose
       precision.
 
+      to_fixed_point(num, scale) sets `num' and `scale' so that the
+      amount is exactly num / 10^scale, and returns true, if the amount
+      is held inline.  It uses no shared state, so it is safe to call
+      from several threads at once.
+
       to_string() returns an amount'ss "display value" as a string --
       after rounding the value according to the commodity's default
       precision.  It is equivalent to: `round().to_fullstring()'.
@@ -515,6 +554,7 @@ public:
   double to_double() const;
   long   to_long() const;
   bool   fits_in_long() const;
+  bool   to_fixed_point(int_least64_t& num, uint_least8_t& scale) const;
 
   operator string() const {
     return to_string();
@@ -720,6 +760,24 @@ public:
 
   /*@}*/
 
+  /** @name Serialization
+   */
+  /*@{*/
+
+  /** write_quantity(buffer) appends the exact internal quantity of an
+      amount, including its internal precision and whether that precision
+      is kept, to `buffer' in a compact binary form.
+      read_quantity(data, len) restores a quantity written this way and
+      returns the number of bytes consumed.  The commodity is not
+      included; it is the caller's job to record it and to call
+      set_commodity afterward.  These are used by the journal cache (see
+      cache.h).
+  */
+  void        write_quantity(string& buffer) const;
+  std::size_t read_quantity(const char * data, const std::size_t len);
+
+  /*@}*/
+
   /** @name Debugging
    */
   /*@{*/
@@ -50,6 +50,7 @@
 #define _BALANCE_H
 
 #include "amount.h"
+#include "flatmap.h"
 
 namespace ledger {
 
@@ -80,7 +81,9 @@ class balance_t
            multiplicative<balance_t, long> > > > > > > > > > > > > >
 {
 public:
-  typedef std::map<commodity_t *, amount_t> amounts_map;
+  /** Most balances hold only one or two commodities, so the amounts are
+      kept inline in a small sorted array rather than in tree nodes. */
+  typedef flat_map<commodity_t *, amount_t> amounts_map;
 
   amounts_map amounts;
 
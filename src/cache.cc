@@ -0,0 +1,1018 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <system.hh>
+
+#include "cache.h"
+#include "journal.h"
+#include "xact.h"
+#include "post.h"
+#include "account.h"
+#include "pool.h"
+#include "annotate.h"
+#include "context.h"
+
+namespace ledger {
+
+namespace {
+  const char           cache_magic[8] = { 'L', 'E', 'D', 'G', 'E', 'R',
+                                          'J', 'C' };
+  const uint_least32_t cache_format   = 2;
+  const uint_least32_t no_index       = 0xffffffff;
+
+  const datetime_t cache_epoch(date_t(1970, 1, 1));
+
+  typedef file_hash_t hash_t;
+
+  hash_t hash_file(const path& pathname)
+  {
+    if (file_mapping_t mapping = map_journal_file(pathname))
+      return hash_file_bytes(mapping->const_data(), mapping->size());
+
+    hash_t hash = hash_file_bytes(NULL, 0);
+    ifstream in(pathname, std::ios::binary);
+    char buf[65536];
+    while (in.good()) {
+      in.read(buf, sizeof(buf));
+      hash = hash_file_bytes(buf, static_cast<std::size_t>(in.gcount()),
+                             hash);
+    }
+    return hash;
+  }
+
+  datetime_t file_modtime(const path& pathname)
+  {
+    return posix_time::from_time_t(last_write_time(pathname));
+  }
+
+  class cache_writer_t : public noncopyable
+  {
+    typedef std::map<const commodity_t *, uint_least32_t> commodity_index_map;
+    typedef std::map<const account_t *, uint_least32_t>   account_index_map;
+    typedef std::map<const post_t *, uint_least32_t>      post_index_map;
+    typedef std::map<path, uint_least32_t>                path_index_map;
+
+    string&             out;
+    commodity_index_map commodities;
+    account_index_map   accounts;
+    post_index_map      posts;
+    path_index_map      paths;
+
+  public:
+    explicit cache_writer_t(string& _out) : out(_out) {}
+
+    template <typename T>
+    void write_number(const T num) {
+      out.append(reinterpret_cast<const char *>(&num), sizeof(T));
+    }
+
+    void write_bool(const bool truth) {
+      write_number<uint_least8_t>(truth ? 1 : 0);
+    }
+
+    template <typename T>
+    bool write_present(const optional<T>& value) {
+      write_bool(static_cast<bool>(value));
+      return static_cast<bool>(value);
+    }
+
+    void write_string(const string& str) {
+      write_number<uint_least32_t>(static_cast<uint_least32_t>(str.length()));
+      out.append(str);
+    }
+
+    void write_optional_string(const optional<string>& str) {
+      if (write_present(str))
+        write_string(*str);
+    }
+
+    void write_date(const date_t& when) {
+      write_number<int_least32_t>
+        (static_cast<int_least32_t>((when - cache_epoch.date()).days()));
+    }
+
+    void write_datetime(const datetime_t& when) {
+      write_number<int_least64_t>
+        (when.is_special() ? std::numeric_limits<int_least64_t>::min() :
+         static_cast<int_least64_t>((when - cache_epoch).total_microseconds()));
+    }
+
+    void write_path(const path& pathname) {
+      path_index_map::const_iterator i = paths.find(pathname);
+      if (i != paths.end()) {
+        write_number((*i).second);
+      } else {
+        // A path is written out in full the first time it is seen, and by
+        // index after that.
+        uint_least32_t index = static_cast<uint_least32_t>(paths.size());
+        paths.insert(path_index_map::value_type(pathname, index));
+        write_number(index);
+        write_string(pathname.string());
+      }
+    }
+
+    void write_commodity_ref(const commodity_t * comm) {
+      commodity_index_map::const_iterator i = commodities.find(comm);
+      if (i == commodities.end())
+        throw_(cache_error,
+               _f("Commodity '%1%' is not known to the commodity pool")
+               % comm->symbol());
+      write_number((*i).second);
+    }
+
+    void write_account_ref(const account_t * acct) {
+      if (! acct) {
+        write_number(no_index);
+        return;
+      }
+      account_index_map::const_iterator i = accounts.find(acct);
+      if (i == accounts.end())
+        throw_(cache_error, _f("Account '%1%' is not part of the journal")
+               % acct->fullname());
+      write_number((*i).second);
+    }
+
+    void write_amount(const amount_t& amt) {
+      write_commodity_ref(amt.has_commodity() ? &amt.commodity() : NULL);
+      amt.write_quantity(out);
+    }
+
+    void write_optional_amount(const optional<amount_t>& amt) {
+      if (write_present(amt))
+        write_amount(*amt);
+    }
+
+    void write_value(const value_t& value);
+    void write_commodities(commodity_pool_t& pool);
+    void write_accounts(account_t * master);
+    void write_item(const item_t& item);
+    void write_post(const post_t& post);
+    void write_xact(const xact_t& xact);
+    void write_journal(journal_t& journal);
+  };
+
+  struct price_collector_t
+  {
+    typedef std::pair<const commodity_t *, price_point_t> price_entry_t;
+
+    std::vector<price_entry_t>& prices;
+
+    explicit price_collector_t(std::vector<price_entry_t>& _prices)
+      : prices(_prices) {}
+
+    void operator()(const commodity_t& source, const datetime_t& when,
+                    const amount_t& price) {
+      prices.push_back(price_entry_t(&source, price_point_t(when, price)));
+    }
+  };
+
+  void cache_writer_t::write_value(const value_t& value)
+  {
+    write_number<uint_least8_t>(static_cast<uint_least8_t>(value.type()));
+
+    switch (value.type()) {
+    case value_t::VOID:
+      break;
+    case value_t::BOOLEAN:
+      write_bool(value.as_boolean());
+      break;
+    case value_t::DATETIME:
+      write_datetime(value.as_datetime());
+      break;
+    case value_t::DATE:
+      write_date(value.as_date());
+      break;
+    case value_t::INTEGER:
+      write_number<int_least64_t>(value.as_long());
+      break;
+    case value_t::AMOUNT:
+      write_amount(value.as_amount());
+      break;
+    case value_t::STRING:
+      write_string(value.as_string());
+      break;
+    default:
+      throw_(cache_error, _f("Cannot cache metadata values of type %1%")
+             % value.label());
+    }
+  }
+
+  void cache_writer_t::write_commodities(commodity_pool_t& pool)
+  {
+    std::vector<commodity_t *>                     bases;
+    std::vector<std::pair<string, commodity_t *> > aliases;
+
+    // The null commodity always exists, and is referred to as index zero,
+    // as are amounts that have no commodity at all.
+    commodities.insert(commodity_index_map::value_type(NULL, 0));
+    commodities.insert(commodity_index_map::value_type(pool.null_commodity, 0));
+
+    foreach (commodity_pool_t::commodities_map::value_type& pair,
+             pool.commodities) {
+      commodity_t * comm = pair.second.get();
+      if (comm == pool.null_commodity)
+        continue;
+
+      if (pair.first != comm->base_symbol()) {
+        aliases.push_back(std::pair<string, commodity_t *>(pair.first, comm));
+        continue;
+      }
+      if (comm->value_expr())
+        throw_(cache_error, _f("Commodity '%1%' has a value expression")
+               % comm->symbol());
+
+      bases.push_back(comm);
+      commodities.insert(commodity_index_map::value_type
+                         (comm, static_cast<uint_least32_t>(bases.size())));
+    }
+
+    write_number(static_cast<uint_least32_t>(bases.size()));
+    foreach (commodity_t * comm, bases) {
+      write_string(comm->base_symbol());
+      write_number<uint_least16_t>(comm->flags());
+      write_number<uint_least16_t>(comm->precision());
+      write_optional_string(comm->name());
+      write_optional_string(comm->note());
+    }
+
+    write_number(static_cast<uint_least32_t>(aliases.size()));
+    typedef std::pair<string, commodity_t *> alias_pair;
+    foreach (const alias_pair& alias, aliases) {
+      write_string(alias.first);
+      write_commodity_ref(alias.second);
+    }
+
+    uint_least32_t next_index = static_cast<uint_least32_t>(bases.size() + 1);
+
+    write_number(static_cast<uint_least32_t>(pool.annotated_commodities.size()));
+    foreach (commodity_pool_t::annotated_commodities_map::value_type& pair,
+             pool.annotated_commodities) {
+      annotated_commodity_t *  comm = pair.second.get();
+      const annotation_t& details(comm->details);
+
+      // Annotated commodities are recreated in the order written, so the
+      // price of a lot may only refer to a plain commodity.
+      if (details.price && details.price->has_commodity() &&
+          details.price->commodity().has_annotation())
+        throw_(cache_error,
+               _f("Lot price of '%1%' is itself annotated") % comm->symbol());
+
+      write_commodity_ref(&comm->referent());
+      write_number<uint_least8_t>(details.flags());
+      write_optional_amount(details.price);
+      if (write_present(details.date))
+        write_date(*details.date);
+      write_optional_string(details.tag);
+      if (write_present(details.value_expr))
+        write_string(details.value_expr->text());
+
+      commodities.insert(commodity_index_map::value_type(comm, next_index++));
+    }
+
+    write_commodity_ref(pool.default_commodity);
+
+    foreach (commodity_t * comm, bases) {
+      write_optional_amount(comm->smaller());
+      write_optional_amount(comm->larger());
+    }
+
+    std::vector<price_collector_t::price_entry_t> prices;
+    pool.commodity_price_history.map_all_prices(price_collector_t(prices));
+
+    write_number(static_cast<uint_least32_t>(prices.size()));
+    foreach (const price_collector_t::price_entry_t& entry, prices) {
+      write_commodity_ref(entry.first);
+      write_datetime(entry.second.when);
+      write_amount(entry.second.price);
+    }
+  }
+
+  void cache_writer_t::write_accounts(account_t * master)
+  {
+    std::vector<account_t *> all;
+    all.push_back(master);
+
+    // Walk the tree breadth-first, so that every parent is written before
+    // its children.
+    for (std::size_t i = 0; i < all.size(); i++) {
+      account_t * acct = all[i];
+      if (acct->value_expr)
+        throw_(cache_error, _f("Account '%1%' has a value expression")
+               % acct->fullname());
+      if (acct->deferred_posts && ! acct->deferred_posts->empty())
+        throw_(cache_error, _f("Account '%1%' has deferred postings")
+               % acct->fullname());
+
+      accounts.insert(account_index_map::value_type
+                      (acct, static_cast<uint_least32_t>(i)));
+      foreach (accounts_map::value_type& pair, acct->accounts)
+        all.push_back(pair.second);
+    }
+
+    write_number(static_cast<uint_least32_t>(all.size() - 1));
+    for (std::size_t i = 1; i < all.size(); i++) {
+      write_account_ref(all[i]->parent);
+      write_string(all[i]->name);
+      write_number<uint_least8_t>(all[i]->flags());
+      write_optional_string(all[i]->note);
+    }
+  }
+
+  void cache_writer_t::write_item(const item_t& item)
+  {
+    write_number<uint_least16_t>(item.flags());
+    write_number<uint_least8_t>(static_cast<uint_least8_t>(item._state));
+    if (write_present(item._date))
+      write_date(*item._date);
+    if (write_present(item._date_aux))
+      write_date(*item._date_aux);
+    write_optional_string(item.note);
+
+    if (write_present(item.pos)) {
+      write_path(item.pos->pathname);
+      write_number<int_least64_t>(std::streamoff(item.pos->beg_pos));
+      write_number<uint_least64_t>(item.pos->beg_line);
+      write_number<int_least64_t>(std::streamoff(item.pos->end_pos));
+      write_number<uint_least64_t>(item.pos->end_line);
+      write_number<uint_least64_t>(item.pos->sequence);
+    }
+
+    if (write_present(item.metadata)) {
+      write_number(static_cast<uint_least32_t>(item.metadata->size()));
+      foreach (const item_t::string_map::value_type& pair, *item.metadata) {
+        write_string(pair.first);
+        if (write_present(pair.second.first))
+          write_value(*pair.second.first);
+        write_bool(pair.second.second);
+      }
+    }
+  }
+
+  void cache_writer_t::write_post(const post_t& post)
+  {
+    posts.insert(post_index_map::value_type
+                 (&post, static_cast<uint_least32_t>(posts.size())));
+
+    write_item(post);
+    write_account_ref(post.account);
+    write_amount(post.amount);
+    if (write_present(post.amount_expr))
+      write_string(post.amount_expr->text());
+    write_optional_amount(post.cost);
+    write_optional_amount(post.given_cost);
+    write_optional_amount(post.assigned_amount);
+    if (write_present(post.checkin))
+      write_datetime(*post.checkin);
+    if (write_present(post.checkout))
+      write_datetime(*post.checkout);
+  }
+
+  void cache_writer_t::write_xact(const xact_t& xact)
+  {
+    write_item(xact);
+    write_optional_string(xact.code);
+    write_string(xact.payee);
+
+    write_number(static_cast<uint_least32_t>(xact.posts.size()));
+    foreach (const post_t * post, xact.posts)
+      write_post(*post);
+  }
+
+  void cache_writer_t::write_journal(journal_t& journal)
+  {
+    if (! journal.cacheable)
+      throw_(cache_error, _("Journal uses directives with side-effects"));
+    if (! journal.auto_xacts.empty())
+      throw_(cache_error, _("Journal contains automated transactions"));
+    if (! journal.period_xacts.empty())
+      throw_(cache_error, _("Journal contains periodic transactions"));
+
+    write_commodities(*commodity_pool_t::current_pool);
+    write_accounts(journal.master);
+    write_account_ref(journal.bucket);
+
+    write_number(static_cast<uint_least32_t>(journal.known_payees.size()));
+    foreach (const string& payee, journal.known_payees)
+      write_string(payee);
+    write_number(static_cast<uint_least32_t>(journal.known_tags.size()));
+    foreach (const string& tag, journal.known_tags)
+      write_string(tag);
+
+    write_number(static_cast<uint_least32_t>(journal.xacts.size()));
+    foreach (const xact_t * xact, journal.xacts)
+      write_xact(*xact);
+
+    // Each account's list of postings is written separately, since its
+    // order need not follow the order of transactions.
+    typedef std::pair<const account_t *, uint_least32_t> account_index_pair;
+    std::vector<const account_t *> by_index(accounts.size());
+    foreach (const account_index_pair& pair, accounts)
+      by_index[pair.second] = pair.first;
+
+    foreach (const account_t * acct, by_index) {
+      write_number(static_cast<uint_least32_t>(acct->posts.size()));
+      foreach (const post_t * post, acct->posts) {
+        post_index_map::const_iterator i = posts.find(post);
+        if (i == posts.end())
+          throw_(cache_error,
+                 _f("Account '%1%' refers to a posting outside the journal")
+                 % acct->fullname());
+        write_number((*i).second);
+      }
+    }
+  }
+
+  class cache_reader_t : public noncopyable
+  {
+    const char *               pos;
+    const char *               end;
+    std::vector<commodity_t *> commodities;
+    std::vector<account_t *>   accounts;
+    std::vector<post_t *>      posts;
+    std::vector<path>          paths;
+
+    // Nothing read from the cache reaches `pool' before commit(), so that
+    // a cache which turns out to be damaged leaves it as it was.  Until
+    // then, commodities it does not know are made in `created', and the
+    // rest of what is read about commodities is kept here.
+    struct base_details_t
+    {
+      commodity_t *        comm;
+      uint_least16_t       flags;
+      amount_t::precision_t precision;
+      optional<string>     name;
+      optional<string>     note;
+      optional<amount_t>   smaller;
+      optional<amount_t>   larger;
+    };
+
+    struct price_details_t
+    {
+      commodity_t * source;
+      datetime_t    when;
+      amount_t      price;
+    };
+
+    commodity_pool_t&                               pool;
+    commodity_pool_t                                created;
+    std::vector<base_details_t>                     bases;
+    std::vector<std::pair<string, commodity_t *> > aliases;
+    commodity_t *                                   default_commodity;
+    std::vector<price_details_t>                    prices;
+
+  public:
+    cache_reader_t(const char * data, std::size_t len,
+                   commodity_pool_t& _pool)
+      : pos(data), end(data + len), pool(_pool), default_commodity(NULL) {}
+
+    const char * position() const {
+      return pos;
+    }
+
+    void read_bytes(char * buf, std::size_t len) {
+      if (static_cast<std::size_t>(end - pos) < len)
+        throw_(cache_error, _("Journal cache is truncated"));
+      std::memcpy(buf, pos, len);
+      pos += len;
+    }
+
+    template <typename T>
+    T read_number() {
+      T num;
+      read_bytes(reinterpret_cast<char *>(&num), sizeof(T));
+      return num;
+    }
+
+    bool read_bool() {
+      return read_number<uint_least8_t>() != 0;
+    }
+
+    string read_string() {
+      uint_least32_t len = read_number<uint_least32_t>();
+      if (static_cast<std::size_t>(end - pos) < len)
+        throw_(cache_error, _("Journal cache is truncated"));
+      string str(pos, len);
+      pos += len;
+      return str;
+    }
+
+    optional<string> read_optional_string() {
+      if (read_bool())
+        return read_string();
+      return none;
+    }
+
+    date_t read_date() {
+      return cache_epoch.date() +
+        gregorian::date_duration(read_number<int_least32_t>());
+    }
+
+    datetime_t read_datetime() {
+      int_least64_t usecs = read_number<int_least64_t>();
+      if (usecs == std::numeric_limits<int_least64_t>::min())
+        return datetime_t();
+      return cache_epoch + posix_time::microseconds(usecs);
+    }
+
+    path read_path() {
+      uint_least32_t index = read_number<uint_least32_t>();
+      if (index == paths.size())
+        paths.push_back(path(read_string()));
+      else if (index > paths.size())
+        throw_(cache_error, _("Journal cache refers to an unknown file"));
+      return paths[index];
+    }
+
+    commodity_t * read_commodity_ref() {
+      uint_least32_t index = read_number<uint_least32_t>();
+      if (index >= commodities.size())
+        throw_(cache_error, _("Journal cache refers to an unknown commodity"));
+      return commodities[index];
+    }
+
+    account_t * read_account_ref() {
+      uint_least32_t index = read_number<uint_least32_t>();
+      if (index == no_index)
+        return NULL;
+      if (index >= accounts.size())
+        throw_(cache_error, _("Journal cache refers to an unknown account"));
+      return accounts[index];
+    }
+
+    amount_t read_amount() {
+      commodity_t * comm = read_commodity_ref();
+      amount_t amt;
+      pos += amt.read_quantity(pos, static_cast<std::size_t>(end - pos));
+      if (comm && ! amt.is_null())
+        amt.set_commodity(*comm);
+      return amt;
+    }
+
+    optional<amount_t> read_optional_amount() {
+      if (read_bool())
+        return read_amount();
+      return none;
+    }
+
+    value_t read_value();
+    void read_commodities();
+    void read_accounts(account_t * master);
+    void read_item(item_t& item);
+    post_t * read_post(xact_t * xact);
+    xact_t * read_xact(journal_t& journal);
+    void read_journal(journal_t& journal);
+    void commit();
+  };
+
+  value_t cache_reader_t::read_value()
+  {
+    switch (read_number<uint_least8_t>()) {
+    case value_t::VOID:
+      return value_t();
+    case value_t::BOOLEAN:
+      return value_t(read_bool());
+    case value_t::DATETIME:
+      return value_t(read_datetime());
+    case value_t::DATE:
+      return value_t(read_date());
+    case value_t::INTEGER:
+      return value_t(static_cast<long>(read_number<int_least64_t>()));
+    case value_t::AMOUNT:
+      return value_t(read_amount());
+    case value_t::STRING:
+      return string_value(read_string());
+    default:
+      throw_(cache_error, _("Journal cache contains an unknown value type"));
+    }
+    return NULL_VALUE;
+  }
+
+  void cache_reader_t::read_commodities()
+  {
+    commodities.push_back(NULL);
+
+    uint_least32_t count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++) {
+      string        symbol(read_string());
+      commodity_t * comm = pool.find(symbol);
+      if (! comm)
+        comm = created.find_or_create(symbol);
+
+      base_details_t base;
+      base.comm      = comm;
+      base.flags     = read_number<uint_least16_t>();
+      base.precision = read_number<uint_least16_t>();
+      base.name      = read_optional_string();
+      base.note      = read_optional_string();
+      bases.push_back(base);
+
+      commodities.push_back(comm);
+    }
+
+    count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++) {
+      string        name(read_string());
+      commodity_t * comm = read_commodity_ref();
+      if (! comm)
+        throw_(cache_error, _("Journal cache contains an invalid alias"));
+      aliases.push_back(std::pair<string, commodity_t *>(name, comm));
+    }
+
+    count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++) {
+      commodity_t * comm = read_commodity_ref();
+      if (! comm)
+        throw_(cache_error,
+               _("Journal cache contains an invalid annotated commodity"));
+
+      annotation_t details;
+      details.set_flags(read_number<uint_least8_t>());
+      details.price = read_optional_amount();
+      if (read_bool())
+        details.date = read_date();
+      details.tag = read_optional_string();
+      if (read_bool())
+        details.value_expr = expr_t(read_string());
+
+      commodity_t * ann_comm = pool.find(comm->base_symbol(), details);
+      if (! ann_comm) {
+        // Making an annotated commodity marks its base as having been
+        // seen annotated, but the base's flags must wait for commit().
+        uint_least16_t flags = comm->flags();
+        ann_comm = created.find_or_create(*comm, details);
+        comm->set_flags(flags);
+      }
+      commodities.push_back(ann_comm);
+    }
+
+    default_commodity = read_commodity_ref();
+
+    foreach (base_details_t& base, bases) {
+      base.smaller = read_optional_amount();
+      base.larger  = read_optional_amount();
+    }
+
+    count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++) {
+      price_details_t price;
+      price.source = read_commodity_ref();
+      price.when   = read_datetime();
+      price.price  = read_amount();
+      if (! price.source || ! price.price.has_commodity())
+        throw_(cache_error, _("Journal cache contains an invalid price"));
+      prices.push_back(price);
+    }
+  }
+
+  void cache_reader_t::read_accounts(account_t * master)
+  {
+    accounts.push_back(master);
+
+    uint_least32_t count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++) {
+      account_t * parent = read_account_ref();
+      if (! parent)
+        throw_(cache_error, _("Journal cache contains an orphaned account"));
+
+      account_t * acct = parent->find_account(read_string());
+      acct->set_flags(read_number<uint_least8_t>());
+      acct->note = read_optional_string();
+      accounts.push_back(acct);
+    }
+  }
+
+  void cache_reader_t::read_item(item_t& item)
+  {
+    item.set_flags(read_number<uint_least16_t>());
+    item._state = static_cast<item_t::state_t>(read_number<uint_least8_t>());
+    if (read_bool())
+      item._date = read_date();
+    if (read_bool())
+      item._date_aux = read_date();
+    item.note = read_optional_string();
+
+    if (read_bool()) {
+      position_t pos;
+      pos.pathname = read_path();
+      pos.beg_pos  = read_number<int_least64_t>();
+      pos.beg_line = static_cast<std::size_t>(read_number<uint_least64_t>());
+      pos.end_pos  = read_number<int_least64_t>();
+      pos.end_line = static_cast<std::size_t>(read_number<uint_least64_t>());
+      pos.sequence = static_cast<std::size_t>(read_number<uint_least64_t>());
+      item.pos = pos;
+    }
+
+    if (read_bool()) {
+      uint_least32_t count = read_number<uint_least32_t>();
+      for (uint_least32_t i = 0; i < count; i++) {
+        string            tag(read_string());
+        optional<value_t> value;
+        if (read_bool())
+          value = read_value();
+        item_t::string_map::iterator j = item.set_tag(tag, value);
+        (*j).second.second = read_bool();
+      }
+    }
+  }
+
+  post_t * cache_reader_t::read_post(xact_t * xact)
+  {
+    unique_ptr<post_t> post(new post_t);
+
+    read_item(*post);
+    post->xact    = xact;
+    post->account = read_account_ref();
+    post->amount  = read_amount();
+    if (read_bool())
+      post->amount_expr = expr_t(read_string());
+    post->cost            = read_optional_amount();
+    post->given_cost      = read_optional_amount();
+    post->assigned_amount = read_optional_amount();
+    if (read_bool())
+      post->checkin = read_datetime();
+    if (read_bool())
+      post->checkout = read_datetime();
+
+    posts.push_back(post.get());
+    return post.release();
+  }
+
+  xact_t * cache_reader_t::read_xact(journal_t& journal)
+  {
+    unique_ptr<xact_t> xact(new xact_t);
+
+    read_item(*xact);
+    xact->code    = read_optional_string();
+    xact->payee   = read_string();
+    xact->journal = &journal;
+
+    uint_least32_t count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++)
+      xact->add_post(read_post(xact.get()));
+
+    return xact.release();
+  }
+
+  void cache_reader_t::read_journal(journal_t& journal)
+  {
+    read_commodities();
+    read_accounts(journal.master);
+    journal.bucket = read_account_ref();
+
+    uint_least32_t count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++)
+      journal.known_payees.insert(read_string());
+    count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++)
+      journal.known_tags.insert(read_string());
+
+    count = read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++) {
+      xact_t * xact = read_xact(journal);
+      journal.xacts.push_back(xact);
+
+      if (optional<value_t> ref = xact->get_tag(_("UUID")))
+        journal.checksum_map.insert
+          (checksum_map_t::value_type(ref->to_string(), xact));
+    }
+
+    foreach (account_t * acct, accounts) {
+      count = read_number<uint_least32_t>();
+      for (uint_least32_t i = 0; i < count; i++) {
+        uint_least32_t index = read_number<uint_least32_t>();
+        if (index >= posts.size())
+          throw_(cache_error,
+                 _("Journal cache refers to an unknown posting"));
+        acct->add_post(posts[index]);
+      }
+    }
+  }
+
+  void cache_reader_t::commit()
+  {
+    pool.adopt(created);
+
+    foreach (const base_details_t& base, bases) {
+      base.comm->set_flags(base.flags);
+      base.comm->set_precision(base.precision);
+      base.comm->set_name(base.name);
+      base.comm->set_note(base.note);
+      base.comm->set_smaller(base.smaller);
+      base.comm->set_larger(base.larger);
+    }
+
+    typedef std::pair<string, commodity_t *> alias_t;
+    foreach (const alias_t& alias, aliases)
+      if (! pool.find(alias.first))
+        pool.alias(alias.first, *alias.second);
+
+    if (default_commodity)
+      pool.default_commodity = default_commodity;
+
+    foreach (const price_details_t& price, prices)
+      pool.commodity_price_history.add_price(*price.source, price.when,
+                                             price.price);
+  }
+}
+
+bool read_journal_cache(const path&   cache_file,
+                        journal_t&    journal,
+                        const string& signature)
+{
+  file_mapping_t mapping = map_journal_file(cache_file);
+  if (! mapping)
+    return false;
+
+  cache_reader_t reader(mapping->const_data(), mapping->size(),
+                        *commodity_pool_t::current_pool);
+
+  std::list<journal_t::fileinfo_t> sources;
+  try {
+    char magic[sizeof(cache_magic)];
+    reader.read_bytes(magic, sizeof(magic));
+    if (std::memcmp(magic, cache_magic, sizeof(magic)) != 0 ||
+        reader.read_number<uint_least32_t>() != cache_format) {
+      DEBUG("journal.cache", "Not a journal cache: " << cache_file);
+      return false;
+    }
+    if (reader.read_string() != signature) {
+      DEBUG("journal.cache", "Session options differ for " << cache_file);
+      return false;
+    }
+
+    uint_least32_t count = reader.read_number<uint_least32_t>();
+    for (uint_least32_t i = 0; i < count; i++) {
+      journal_t::fileinfo_t info;
+      info.filename    = path(reader.read_string());
+      info.size        = reader.read_number<uint_least64_t>();
+      info.modtime     = reader.read_datetime();
+      info.from_stream = false;
+      hash_t hash      = reader.read_number<hash_t>();
+
+      const path& pathname(*info.filename);
+      if (! exists(pathname) || file_size(pathname) != info.size ||
+          file_modtime(pathname) != info.modtime ||
+          hash_file(pathname) != hash) {
+        DEBUG("journal.cache", "Source file has changed: " << pathname);
+        return false;
+      }
+      sources.push_back(info);
+    }
+
+    uint_least64_t length = reader.read_number<uint_least64_t>();
+    hash_t         hash   = reader.read_number<hash_t>();
+    std::size_t    offset =
+      static_cast<std::size_t>(reader.position() - mapping->const_data());
+    if (offset + length != mapping->size() ||
+        hash_file_bytes(mapping->const_data() + offset,
+                        static_cast<std::size_t>(length)) != hash) {
+      DEBUG("journal.cache", "Journal cache is damaged: " << cache_file);
+      return false;
+    }
+  }
+  catch (const cache_error&) {
+    DEBUG("journal.cache", "Journal cache is truncated: " << cache_file);
+    return false;
+  }
+  catch (const filesystem_error&) {
+    return false;
+  }
+
+  // The contents have already been verified against their checksum, so a
+  // failure here means the cache was written by an incompatible build.
+  // They are read into a scratch journal, and the commodity pool is only
+  // changed once all of them have been read, so that the caller can fall
+  // back to parsing with both untouched.
+  journal_t scratch;
+  try {
+    reader.read_journal(scratch);
+    reader.commit();
+  }
+  catch (const std::exception& err) {
+    DEBUG("journal.cache", "Cannot read journal cache " << cache_file
+          << ": " << err.what());
+    return false;
+  }
+
+  std::swap(journal.master, scratch.master);
+  journal.bucket = scratch.bucket;
+  journal.known_payees.swap(scratch.known_payees);
+  journal.known_tags.swap(scratch.known_tags);
+  journal.checksum_map.swap(scratch.checksum_map);
+  journal.xacts.swap(scratch.xacts);
+  foreach (xact_t * xact, journal.xacts)
+    xact->journal = &journal;
+
+  journal.sources = sources;
+
+  DEBUG("journal.cache", "Read " << journal.xacts.size()
+        << " transactions from " << cache_file);
+  return true;
+}
+
+bool write_journal_cache(const path&   cache_file,
+                         journal_t&    journal,
+                         const string& signature)
+{
+  string header;
+  string body;
+
+  try {
+    cache_writer_t writer(body);
+    writer.write_journal(journal);
+
+    header.append(cache_magic, sizeof(cache_magic));
+    cache_writer_t head(header);
+    head.write_number(cache_format);
+    head.write_string(signature);
+
+    head.write_number(static_cast<uint_least32_t>(journal.sources.size()));
+    foreach (const journal_t::fileinfo_t& info, journal.sources) {
+      if (info.from_stream || ! info.filename)
+        throw_(cache_error, _("Journal was read from a stream"));
+
+      // Make sure the file has not changed since it was parsed, otherwise
+      // the hash would describe contents that the journal does not hold.
+      const path& pathname(*info.filename);
+      if (file_size(pathname) != info.size ||
+          file_modtime(pathname) != info.modtime)
+        throw_(cache_error, _f("File %1% changed while being read")
+               % pathname);
+
+      head.write_string(pathname.string());
+      head.write_number<uint_least64_t>(info.size);
+      head.write_datetime(info.modtime);
+      head.write_number<hash_t>(hash_file(pathname));
+    }
+  }
+  catch (const cache_error& err) {
+    DEBUG("journal.cache", "Not caching journal: " << err.what());
+    return false;
+  }
+  catch (const filesystem_error& err) {
+    DEBUG("journal.cache", "Not caching journal: " << err.what());
+    return false;
+  }
+
+  cache_writer_t(header).write_number<uint_least64_t>(body.length());
+  cache_writer_t(header).write_number<hash_t>
+    (hash_file_bytes(body.data(), body.length()));
+
+  // Write to a temporary file first and then rename it into place, so
+  // that another ledger process never sees a partial cache.
+  path temp(cache_file.string() + ".tmp");
+  {
+    ofstream out(temp, std::ios::binary | std::ios::trunc);
+    out.write(header.data(), static_cast<std::streamsize>(header.length()));
+    out.write(body.data(), static_cast<std::streamsize>(body.length()));
+    out.close();
+    if (! out) {
+      boost::system::error_code ec;
+      remove(temp, ec);
+      DEBUG("journal.cache", "Failed to write journal cache " << temp);
+      return false;
+    }
+  }
+
+  boost::system::error_code ec;
+  rename(temp, cache_file, ec);
+  if (ec) {
+    remove(temp, ec);
+    DEBUG("journal.cache", "Failed to rename journal cache: " << ec.message());
+    return false;
+  }
+
+  DEBUG("journal.cache", "Wrote " << journal.xacts.size()
+        << " transactions to " << cache_file);
+  return true;
+}
+
+} // namespace ledger
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup data
+ */
+
+/**
+ * @file   cache.h
+ * @author John Wiegley
+ *
+ * @ingroup data
+ *
+ * @brief Binary snapshots of a parsed journal
+ *
+ * A journal cache records the finalized contents of a journal --
+ * commodities, prices, accounts, transactions and postings -- together
+ * with the size, modification time and content hash of every file that
+ * was read to produce it.  When all of those files are unchanged, and the
+ * session options which influence parsing are the same, the journal can
+ * be rebuilt from the snapshot instead of being parsed again.
+ */
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include "utils.h"
+
+namespace ledger {
+
+class journal_t;
+
+DECLARE_EXCEPTION(cache_error, std::runtime_error);
+
+/**
+ * Populate `journal' from the snapshot in `cache_file', provided it was
+ * written with the same `signature' and none of its source files have
+ * changed since.  Returns false, leaving the journal and the commodity
+ * pool untouched, if the snapshot is missing, stale or damaged.
+ */
+bool read_journal_cache(const path&   cache_file,
+                        journal_t&    journal,
+                        const string& signature);
+
+/**
+ * Write a snapshot of `journal' to `cache_file'.  Journals whose meaning
+ * depends on more than their source files (for example, those using
+ * option or eval directives, automated or periodic transactions, or value
+ * expressions) are not written, and false is returned.
+ */
+bool write_journal_cache(const path&   cache_file,
+                         journal_t&    journal,
+                         const string& signature);
+
+} // namespace ledger
+
+#endif // _CACHE_H
@@ -39,6 +39,30 @@
 
 namespace ledger {
 
+namespace {
+  // The filter_posts for --limit which receives the journal's postings
+  // before any other handler.  With --threads, their predicate is tested
+  // by several threads at once.
+  post_handler_ptr first_limit_filter(post_handler_ptr handler,
+                                      report_t&        report)
+  {
+    predicate_t pred(report.HANDLER(limit_).str(), report.what_to_keep());
+
+    std::size_t threads = 1;
+    if (report.HANDLED(threads_))
+      threads = lexical_cast<std::size_t>(report.HANDLER(threads_).str());
+    // Streamed transactions are freed soon after being reported, and
+    // so cannot wait in a batch.
+    if (threads > 1 && ! report.HANDLED(stream))
+      return post_handler_ptr
+        (new parallel_filter_posts(handler, pred, report,
+                                   *report.session.journal->master,
+                                   threads));
+
+    return post_handler_ptr(new filter_posts(handler, pred, report));
+  }
+}
+
 post_handler_ptr chain_pre_post_handlers(post_handler_ptr base_handler,
                                          report_t&        report)
 {
@@ -53,10 +77,14 @@ post_handler_ptr chain_pre_post_handlers(post_handler_ptr base_handler,
   if (report.HANDLED(limit_)) {
     DEBUG("report.predicate",
           "Report predicate expression = " << report.HANDLER(limit_).str());
-    handler.reset(new filter_posts
-                  (handler, predicate_t(report.HANDLER(limit_).str(),
-                                        report.what_to_keep()),
-                   report));
+    if (report.budget_flags != BUDGET_NO_BUDGET ||
+        report.HANDLED(forecast_while_))
+      handler.reset(new filter_posts
+                    (handler, predicate_t(report.HANDLER(limit_).str(),
+                                          report.what_to_keep()),
+                     report));
+    else
+      handler = first_limit_filter(handler, report);
   }
 
   // budget_posts takes a set of posts from a data file and uses them to
@@ -77,10 +105,7 @@ post_handler_ptr chain_pre_post_handlers(post_handler_ptr base_handler,
     // further clean the results so that no automated posts that don't match
     // the filter get reported.
     if (report.HANDLED(limit_))
-      handler.reset(new filter_posts
-                    (handler, predicate_t(report.HANDLER(limit_).str(),
-                                          report.what_to_keep()),
-                     report));
+      handler = first_limit_filter(handler, report);
   }
   else if (report.HANDLED(forecast_while_)) {
     forecast_posts * forecast_handler
@@ -96,10 +121,7 @@ post_handler_ptr chain_pre_post_handlers(post_handler_ptr base_handler,
 
     // See above, under budget_posts.
     if (report.HANDLED(limit_))
-      handler.reset(new filter_posts
-                    (handler, predicate_t(report.HANDLER(limit_).str(),
-                                          report.what_to_keep()),
-                     report));
+      handler = first_limit_filter(handler, report);
   }
 
   return handler;
@@ -113,6 +135,7 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
   predicate_t            display_predicate;
   predicate_t            only_predicate;
   display_filter_posts * display_filter = NULL;
+  truncate_xacts *       truncator      = NULL;
 
   expr_t& expr(report.HANDLER(amount_).expr);
   expr.set_context(&report);
@@ -132,13 +155,20 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
 
     // truncate_xacts cuts off a certain number of _xacts_ from being
     // displayed.  It does not affect calculation.
-    if (report.HANDLED(head_) || report.HANDLED(tail_))
-      handler.reset
-        (new truncate_xacts(handler,
-                            report.HANDLED(head_) ?
-                            lexical_cast<int>(report.HANDLER(head_).value) : 0,
-                            report.HANDLED(tail_) ?
-                            lexical_cast<int>(report.HANDLER(tail_).value) : 0));
+    if (report.HANDLED(head_) || report.HANDLED(tail_)) {
+      int head_count = (report.HANDLED(head_) ?
+                        lexical_cast<int>(report.HANDLER(head_).value) : 0);
+      int tail_count = (report.HANDLED(tail_) ?
+                        lexical_cast<int>(report.HANDLER(tail_).value) : 0);
+      truncate_xacts * truncate =
+        new truncate_xacts(handler, head_count, tail_count);
+      handler.reset(truncate);
+
+      // Only --head alone lets truncate_xacts finish before the last
+      // posting, after which sort_posts need not sort any more of them.
+      if (head_count > 0 && tail_count == 0)
+        truncator = truncate;
+    }
 
     // display_filter_posts adds virtual posts to the list to account
     // for changes in value of commodities, which otherwise would affect
@@ -188,7 +218,8 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
       if (report.HANDLED(sort_xacts_))
         handler.reset(new sort_xacts(handler, expr_t(report.HANDLER(sort_).str()), report));
       else
-        handler.reset(new sort_posts(handler, report.HANDLER(sort_).str(), report));
+        handler.reset(new sort_posts(handler, report.HANDLER(sort_).str(),
+                                     report, truncator));
     }
 
     // collapse_posts causes xacts with multiple posts to appear as xacts
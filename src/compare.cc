@@ -80,27 +80,28 @@ void compare_items<account_t>::find_sort_values(
   push_sort_value(sort_values, sort_order.get_op(), bound_scope);
 }
 
+template <>
+void compare_items<post_t>::calc_sort_values(post_t& post)
+{
+  post_t::xdata_t& xdata(post.xdata());
+  if (! xdata.has_flags(POST_EXT_SORT_CALC)) {
+    bind_scope_t bound_scope(*sort_order.get_context(), post);
+    find_sort_values(xdata.sort_values, bound_scope);
+    xdata.add_flags(POST_EXT_SORT_CALC);
+  }
+}
+
 template <>
 bool compare_items<post_t>::operator()(post_t * left, post_t * right)
 {
   assert(left);
   assert(right);
 
-  post_t::xdata_t& lxdata(left->xdata());
-  if (! lxdata.has_flags(POST_EXT_SORT_CALC)) {
-    bind_scope_t bound_scope(*sort_order.get_context(), *left);
-    find_sort_values(lxdata.sort_values, bound_scope);
-    lxdata.add_flags(POST_EXT_SORT_CALC);
-  }
-
-  post_t::xdata_t& rxdata(right->xdata());
-  if (! rxdata.has_flags(POST_EXT_SORT_CALC)) {
-    bind_scope_t bound_scope(*sort_order.get_context(), *right);
-    find_sort_values(rxdata.sort_values, bound_scope);
-    rxdata.add_flags(POST_EXT_SORT_CALC);
-  }
+  calc_sort_values(*left);
+  calc_sort_values(*right);
 
-  return sort_value_is_less_than(lxdata.sort_values, rxdata.sort_values);
+  return sort_value_is_less_than(left->xdata().sort_values,
+                                 right->xdata().sort_values);
 }
 
 template <>
@@ -129,4 +130,225 @@ bool compare_items<account_t>::operator()(account_t * left, account_t * right)
   return sort_value_is_less_than(lxdata.sort_values, rxdata.sort_values);
 }
 
+namespace {
+  enum sort_key_kind_t {
+    KEY_NUMBER,                 // integers, and amounts of one commodity
+    KEY_DATE,
+    KEY_DATETIME,
+    KEY_STRING
+  };
+
+  struct sort_key_t
+  {
+    int_least64_t  num;
+    const string * str;
+  };
+
+  // The kind of key which orders every value in one column as
+  // sort_value_is_less_than would, if there is one.
+  bool find_key_kind(const std::vector<const sort_value_t *>& column,
+                     sort_key_kind_t& kind, uint_least8_t& scale)
+  {
+    const value_t& first(column.front()->value);
+    if (first.is_date())
+      kind = KEY_DATE;
+    else if (first.is_datetime())
+      kind = KEY_DATETIME;
+    else if (first.is_string())
+      kind = KEY_STRING;
+    else if (first.is_long() || first.is_amount())
+      kind = KEY_NUMBER;
+    else
+      return false;
+
+    const commodity_t * comm = NULL;
+    scale = 0;
+    foreach (const sort_value_t * sort_value, column) {
+      if (sort_value->inverted != column.front()->inverted)
+        return false;
+
+      const value_t& value(sort_value->value);
+      switch (kind) {
+      case KEY_DATE:
+        if (! value.is_date() || value.as_date().is_special())
+          return false;
+        break;
+      case KEY_DATETIME:
+        if (! value.is_datetime() || value.as_datetime().is_special())
+          return false;
+        break;
+      case KEY_STRING:
+        if (! value.is_string())
+          return false;
+        break;
+      case KEY_NUMBER:
+        if (value.is_amount()) {
+          // Amounts of different commodities are ordered by commodity.
+          const amount_t& amt(value.as_amount());
+          if (comm && comm != amt.commodity_ptr())
+            return false;
+          comm = amt.commodity_ptr();
+
+          int_least64_t num;
+          uint_least8_t amt_scale;
+          if (! amt.to_fixed_point(num, amt_scale))
+            return false;
+          scale = std::max(scale, amt_scale);
+        }
+        else if (! value.is_long()) {
+          return false;
+        }
+        break;
+      }
+    }
+    return true;
+  }
+
+  bool encode_number(const value_t& value, const uint_least8_t scale,
+                     int_least64_t& num)
+  {
+    uint_least8_t num_scale = 0;
+    if (value.is_long())
+      num = value.as_long();
+    else
+      value.as_amount().to_fixed_point(num, num_scale);
+
+    const int_least64_t limit =
+      std::numeric_limits<int_least64_t>::max() / 10;
+    for (; num_scale < scale; num_scale++) {
+      if (num > limit || num < - limit)
+        return false;
+      num *= 10;
+    }
+    return true;
+  }
+
+  bool encode_key(const value_t& value, const sort_key_kind_t kind,
+                  const uint_least8_t scale, sort_key_t& key)
+  {
+    static const datetime_t epoch(date_t(1970, 1, 1));
+
+    key.str = NULL;
+    switch (kind) {
+    case KEY_NUMBER:
+      return encode_number(value, scale, key.num);
+    case KEY_DATE:
+      key.num = value.as_date().day_number();
+      break;
+    case KEY_DATETIME:
+      key.num = (value.as_datetime() - epoch).ticks();
+      break;
+    case KEY_STRING:
+      key.str = &value.as_string();
+      break;
+    }
+    return true;
+  }
+
+  class sort_key_less_t
+  {
+    const std::vector<sort_key_t>& keys;
+    const std::vector<bool>&       inverted;
+    const std::size_t              columns;
+
+  public:
+    sort_key_less_t(const std::vector<sort_key_t>& _keys,
+                    const std::vector<bool>&       _inverted)
+      : keys(_keys), inverted(_inverted), columns(_inverted.size()) {}
+
+    bool operator()(const std::size_t left, const std::size_t right) const {
+      const sort_key_t * lkey = &keys[left * columns];
+      const sort_key_t * rkey = &keys[right * columns];
+      for (std::size_t i = 0; i < columns; i++) {
+        int cmp;
+        if (lkey[i].str)
+          cmp = lkey[i].str->compare(*rkey[i].str);
+        else
+          cmp = (lkey[i].num < rkey[i].num ? -1 :
+                 lkey[i].num > rkey[i].num ? 1 : 0);
+        if (cmp < 0)
+          return ! inverted[i];
+        else if (cmp > 0)
+          return inverted[i];
+      }
+      return false;
+    }
+  };
+
+  // Sort each half on its own thread, then merge the two halves.  Both
+  // std::stable_sort and std::inplace_merge keep equal items in order.
+  void parallel_stable_sort(std::vector<std::size_t>::iterator begin,
+                            std::vector<std::size_t>::iterator end,
+                            const sort_key_less_t& less,
+                            const std::size_t threads)
+  {
+    if (threads < 2 || end - begin < 4096) {
+      std::stable_sort(begin, end, less);
+      return;
+    }
+
+    std::vector<std::size_t>::iterator middle = begin + (end - begin) / 2;
+    std::future<void> worker;
+    try {
+      worker = std::async(std::launch::async, parallel_stable_sort,
+                          begin, middle, std::cref(less), threads / 2);
+    }
+    catch (const std::system_error&) {
+      parallel_stable_sort(begin, middle, less, 1);
+    }
+    parallel_stable_sort(middle, end, less, threads - threads / 2);
+    if (worker.valid())
+      worker.get();
+
+    std::inplace_merge(begin, middle, end, less);
+  }
+}
+
+bool sort_posts_by_keys(std::deque<post_t *>& posts, std::size_t threads)
+{
+  if (posts.empty())
+    return true;
+
+  const std::size_t columns = posts.front()->xdata().sort_values.size();
+  std::vector<const sort_value_t *> values;
+  values.reserve(posts.size() * columns);
+  foreach (post_t * post, posts) {
+    const std::list<sort_value_t>& sort_values(post->xdata().sort_values);
+    if (sort_values.size() != columns)
+      return false;
+    foreach (const sort_value_t& sort_value, sort_values)
+      values.push_back(&sort_value);
+  }
+
+  std::vector<sort_key_t> keys(values.size());
+  std::vector<bool>       inverted(columns);
+  for (std::size_t i = 0; i < columns; i++) {
+    std::vector<const sort_value_t *> column;
+    column.reserve(posts.size());
+    for (std::size_t j = i; j < values.size(); j += columns)
+      column.push_back(values[j]);
+
+    sort_key_kind_t kind;
+    uint_least8_t   scale;
+    if (! find_key_kind(column, kind, scale))
+      return false;
+    for (std::size_t j = 0; j < column.size(); j++)
+      if (! encode_key(column[j]->value, kind, scale, keys[j * columns + i]))
+        return false;
+    inverted[i] = column.front()->inverted;
+  }
+
+  std::vector<std::size_t> order(posts.size());
+  for (std::size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  parallel_stable_sort(order.begin(), order.end(),
+                       sort_key_less_t(keys, inverted), threads);
+
+  std::deque<post_t *> sorted;
+  foreach (std::size_t i, order)
+    sorted.push_back(posts[i]);
+  posts.swap(sorted);
+  return true;
+}
+
 } // namespace ledger
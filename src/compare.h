@@ -76,6 +76,10 @@ public:
 
   void find_sort_values(std::list<sort_value_t>& sort_values, scope_t& scope);
 
+  /** Compute the sort values of `item' now, if they were not yet, rather
+      than when it is first compared. */
+  void calc_sort_values(T& item);
+
   bool operator()(T * left, T * right);
 };
 
@@ -89,12 +93,21 @@ bool compare_items<T>::operator()(T * left, T * right)
                                  find_sort_values(right));
 }
 
+template <>
+void compare_items<post_t>::calc_sort_values(post_t& post);
 template <>
 bool compare_items<post_t>::operator()(post_t * left, post_t * right);
 template <>
 bool compare_items<account_t>::operator()(account_t * left,
                                           account_t * right);
 
+/** Stably sort postings whose sort values have all been computed, by
+    first encoding each of those values as a fixed-width key, on up to
+    `threads' threads.  Returns false, leaving `posts' as it was, if
+    some value has no such key, such as a balance or an amount too large
+    to be held in 64 bits. */
+bool sort_posts_by_keys(std::deque<post_t *>& posts, std::size_t threads);
+
 } // namespace ledger
 
 #endif // _COMPARE_H
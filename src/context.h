@@ -51,6 +51,52 @@ class journal_t;
 class account_t;
 class scope_t;
 
+typedef shared_ptr<boost::iostreams::mapped_file> file_mapping_t;
+typedef uint_least64_t                             file_hash_t;
+
+/**
+ * A 64-bit FNV-1a hash over a range of journal bytes.  Used to notice
+ * whether a file has changed beneath a cache or a resumable parse.
+ */
+inline file_hash_t hash_file_bytes(const char *      data,
+                                   const std::size_t len,
+                                   file_hash_t       hash = 0xcbf29ce484222325ULL)
+{
+  for (std::size_t i = 0; i < len; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/**
+ * Map a journal file privately into memory.  If `prefault' is true,
+ * every page is touched so that the file is read in before returning.
+ * This never throws, and is safe to call from a worker thread; on any
+ * failure an empty mapping is returned.
+ */
+inline file_mapping_t map_journal_file(const path& pathname,
+                                       const bool  prefault = false)
+{
+  file_mapping_t mapping;
+  try {
+    if (is_regular_file(pathname) && file_size(pathname) > 0) {
+      mapping.reset(new boost::iostreams::mapped_file
+                    (pathname.string(), boost::iostreams::mapped_file::priv));
+      if (prefault) {
+        volatile char sum = 0;
+        const char * end = mapping->const_data() + mapping->size();
+        for (const char * p = mapping->const_data(); p < end; p += 4096)
+          sum += *p;
+      }
+    }
+  }
+  catch (const std::exception&) {
+    mapping.reset();
+  }
+  return mapping;
+}
+
 class parse_context_t
 {
 public:
@@ -58,6 +104,13 @@ public:
 
   shared_ptr<std::istream> stream;
 
+  // Regular files are also mapped privately into memory, so that the
+  // textual parser can work on lines in place instead of copying each
+  // one out of `stream'.  Stdin and pipes have no mapping.
+  file_mapping_t   mapping;
+  char *           map_pos;
+  char *           map_end;
+
   path             pathname;
   path             current_directory;
   journal_t *      journal;
@@ -71,17 +124,29 @@ public:
   std::size_t      count;
   std::size_t      sequence;
 
+  // Set by the textual parser for a top-level mapped file: a hash of
+  // its whole contents, and whether the parse finished in a state from
+  // which text appended to the file could be parsed on its own.
+  file_hash_t      content_hash;
+  bool             resumable;
+
   explicit parse_context_t(const path& cwd)
-    : current_directory(cwd), master(NULL), scope(NULL),
-      linenum(0), errors(0), count(0), sequence(1) {}
+    : map_pos(NULL), map_end(NULL), current_directory(cwd), master(NULL),
+      scope(NULL), linenum(0), errors(0), count(0), sequence(1),
+      content_hash(hash_file_bytes(NULL, 0)), resumable(false) {}
 
   explicit parse_context_t(shared_ptr<std::istream> _stream,
                            const path& cwd)
-    : stream(_stream), current_directory(cwd), master(NULL),
-      scope(NULL), linenum(0), errors(0), count(0), sequence(1) {}
+    : stream(_stream), map_pos(NULL), map_end(NULL),
+      current_directory(cwd), master(NULL), scope(NULL), linenum(0),
+      errors(0), count(0), sequence(1),
+      content_hash(hash_file_bytes(NULL, 0)), resumable(false) {}
 
   parse_context_t(const parse_context_t& context)
    : stream(context.stream),
+     mapping(context.mapping),
+     map_pos(context.map_pos),
+     map_end(context.map_end),
      pathname(context.pathname),
      current_directory(context.current_directory),
      journal(context.journal),
@@ -92,10 +157,22 @@ public:
      linenum(context.linenum),
      errors(context.errors),
      count(context.count),
-     sequence(context.sequence) {
+     sequence(context.sequence),
+     content_hash(context.content_hash),
+     resumable(context.resumable) {
     std::memcpy(linebuf, context.linebuf, MAX_LINE);
   }
 
+  void set_mapping(file_mapping_t _mapping) {
+    mapping = _mapping;
+    if (mapping) {
+      map_pos = mapping->data();
+      map_end = map_pos + mapping->size();
+    } else {
+      map_pos = map_end = NULL;
+    }
+  }
+
   string location() const {
     return file_context(pathname, linenum);
   }
@@ -109,7 +186,8 @@ public:
 };
 
 inline parse_context_t open_for_reading(const path& pathname,
-                                        const path& cwd)
+                                        const path& cwd,
+                                        optional<file_mapping_t> mapping = none)
 {
   path filename = resolve_path(pathname);
 #if BOOST_VERSION >= 104600 && BOOST_FILESYSTEM_VERSION >= 3
@@ -125,6 +203,7 @@ inline parse_context_t open_for_reading(const path& pathname,
   shared_ptr<std::istream> stream(new ifstream(filename));
   parse_context_t context(stream, parent);
   context.pathname = filename;
+  context.set_mapping(mapping ? *mapping : map_journal_file(filename));
   return context;
 }
 
@@ -132,7 +211,81 @@ class parse_context_stack_t
 {
   std::list<parse_context_t> parsing_context;
 
+  // Files named by include directives are mapped and read in by worker
+  // threads ahead of the parser reaching them.  The parser itself stays
+  // sequential, so at most `max_preloads' files are in flight at once.
+  typedef std::map<path, std::future<file_mapping_t> > preloads_map;
+
+  preloads_map     preloads;
+  std::deque<path> pending_preloads;
+  std::size_t      max_preloads;
+
+  void start_preloads() {
+    while (! pending_preloads.empty() && preloads.size() < max_preloads) {
+      path pathname(pending_preloads.front());
+      pending_preloads.pop_front();
+      if (preloads.find(pathname) != preloads.end())
+        continue;
+      try {
+        preloads.insert(preloads_map::value_type
+                        (pathname, std::async(std::launch::async,
+                                              map_journal_file,
+                                              pathname, true)));
+      }
+      catch (const std::system_error&) {
+        // No thread available; the file will be read when it's reached
+      }
+    }
+  }
+
+  optional<file_mapping_t> take_preload(const path& pathname) {
+    preloads_map::iterator i = preloads.find(pathname);
+    if (i == preloads.end())
+      return none;
+
+    file_mapping_t mapping = (*i).second.get();
+    preloads.erase(i);
+    start_preloads();
+    return mapping;
+  }
+
 public:
+  parse_context_stack_t()
+    : max_preloads(std::max(2U, std::thread::hardware_concurrency())) {}
+
+  // Returns true if the file was not already being preloaded
+  bool preload(const path& pathname) {
+    if (preloads.find(pathname) == preloads.end() &&
+        std::find(pending_preloads.begin(), pending_preloads.end(),
+                  pathname) == pending_preloads.end()) {
+      pending_preloads.push_back(pathname);
+      start_preloads();
+      return true;
+    }
+    return false;
+  }
+
+  // Forgets the preloads of files which turned out not to be included,
+  // releasing their mappings and making room for others.
+  void drop_preloads(const std::list<path>& pathnames) {
+    foreach (const path& pathname, pathnames) {
+      pending_preloads.erase(std::remove(pending_preloads.begin(),
+                                         pending_preloads.end(), pathname),
+                             pending_preloads.end());
+      preloads_map::iterator i = preloads.find(pathname);
+      if (i != preloads.end()) {
+        try {
+          (*i).second.get();
+        }
+        catch (const std::exception&) {
+          // The file was never read, so its errors don't matter
+        }
+        preloads.erase(i);
+      }
+    }
+    start_preloads();
+  }
+
   void push() {
     parsing_context.push_front(parse_context_t(filesystem::current_path()));
   }
@@ -142,7 +295,8 @@ public:
   }
   void push(const path& pathname,
             const path& cwd = filesystem::current_path()) {
-    parsing_context.push_front(open_for_reading(pathname, cwd));
+    parsing_context.push_front(open_for_reading(pathname, cwd,
+                                                take_preload(pathname)));
   }
 
   void push(const parse_context_t& context) {
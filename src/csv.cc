@@ -185,17 +185,13 @@ xact_t * csv_reader::read_xact(bool rich_data)
       break;
 
     case FIELD_PAYEE: {
-      bool found = false;
-      foreach (payee_alias_mapping_t& value, context.journal->payee_alias_mappings) {
-        DEBUG("csv.mappings", "Looking for payee mapping: " << value.first);
-        if (value.first.match(field)) {
-          xact->payee = value.second;
-          found = true;
-          break;
-        }
-      }
-      if (! found)
+      if (payee_alias_mapping_t * value =
+          context.journal->payee_alias_mappings.find(field)) {
+        DEBUG("csv.mappings", "Found payee mapping: " << value->first);
+        xact->payee = value->second;
+      } else {
         xact->payee = field;
+      }
       break;
     }
 
@@ -245,12 +241,9 @@ xact_t * csv_reader::read_xact(bool rich_data)
 
   // Translate the account name, if we have enough information to do so
 
-  foreach (account_mapping_t& value, context.journal->payees_for_unknown_accounts) {
-    if (value.first.match(xact->payee)) {
-      post->account = value.second;
-      break;
-    }
-  }
+  if (account_mapping_t * value =
+      context.journal->payees_for_unknown_accounts.find(xact->payee))
+    post->account = value->second;
 
   xact->add_post(post.release());
 
@@ -37,6 +37,8 @@
 
 namespace ledger {
 
+std::ostream * expr_t::explain_stream = NULL;
+
 expr_t::expr_t() : base_type()
 {
   TRACE_CTOR(expr_t, "");
@@ -120,14 +122,42 @@ void expr_t::compile(scope_t& scope)
 {
   if (! compiled && ptr) {
     ptr = ptr->compile(scope);
+    ptr = ptr->share_common();
     base_type::compile(scope);
+
+    if (explain_stream) {
+      *explain_stream << _("--- Optimized tree for: ") << text() << " ---"
+                      << std::endl;
+      ptr->explain(*explain_stream);
+    }
   }
 }
 
+#if !defined(THREADSAFE)
+namespace {
+  // Gives an evaluation its own serial number, so that the values kept
+  // by shared subexpressions are only reused until it returns.
+  struct calc_serial_guard_t
+  {
+    std::size_t saved;
+
+    calc_serial_guard_t() : saved(expr_t::op_t::calc_serial) {
+      expr_t::op_t::calc_serial = ++expr_t::op_t::last_calc_serial;
+    }
+    ~calc_serial_guard_t() {
+      expr_t::op_t::calc_serial = saved;
+    }
+  };
+}
+#endif
+
 value_t expr_t::real_calc(scope_t& scope)
 {
   if (ptr) {
     ptr_op_t locus;
+#if !defined(THREADSAFE)
+    calc_serial_guard_t serial_guard;
+#endif
     try {
       return ptr->calc(scope, &locus);
     }
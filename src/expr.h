@@ -71,6 +71,12 @@ protected:
   ptr_op_t ptr;
 
 public:
+  /**
+   * When set, each expression is written to this stream as it is
+   * compiled, followed by its optimized tree (see --explain-expr).
+   */
+  static std::ostream * explain_stream;
+
   expr_t();
   expr_t(const expr_t& other);
   expr_t(ptr_op_t _ptr, scope_t * _context = NULL);
@@ -151,10 +151,86 @@ void truncate_xacts::operator()(post_t& post)
   posts.push_back(&post);
 }
 
+namespace {
+  typedef std::pair<post_t *, std::size_t> sort_position_t;
+
+  // Orders postings the other way around from std::stable_sort, which
+  // keeps equal postings in the order they were received, so that a heap
+  // built with it yields them in the same order as stable_sort would.
+  class sort_position_greater
+  {
+    compare_items<post_t>& compare;
+
+  public:
+    sort_position_greater(compare_items<post_t>& _compare)
+      : compare(_compare) {}
+
+    bool operator()(const sort_position_t& left,
+                    const sort_position_t& right) const {
+      if (compare(right.first, left.first))
+        return true;
+      else if (compare(left.first, right.first))
+        return false;
+      return left.second > right.second;
+    }
+  };
+}
+
+void sort_posts::post_leading_posts()
+{
+  if (truncator->finished())
+    return;
+
+  compare_items<post_t> compare(sort_order, report);
+  std::vector<sort_position_t> heap;
+  heap.reserve(posts.size());
+  foreach (post_t * post, posts) {
+    compare.calc_sort_values(*post);
+    heap.push_back(sort_position_t(post, heap.size()));
+  }
+
+  // Building the heap takes linear time, and each posting taken from it
+  // logarithmic time, so the postings after those truncate_xacts reports
+  // are never sorted.
+  sort_position_greater greater(compare);
+  std::make_heap(heap.begin(), heap.end(), greater);
+
+  // The sort values of the postings still in the heap must be kept until
+  // they are taken from it, or every comparison would compute them again.
+  while (! heap.empty() && ! truncator->finished()) {
+    std::pop_heap(heap.begin(), heap.end(), greater);
+    post_t * post = heap.back().first;
+    heap.pop_back();
+
+    post->xdata().drop_flags(POST_EXT_SORT_CALC);
+    item_handler<post_t>::operator()(*post);
+  }
+
+  foreach (sort_position_t& position, heap)
+    position.first->xdata().drop_flags(POST_EXT_SORT_CALC);
+}
+
 void sort_posts::post_accumulated_posts()
 {
-  std::stable_sort(posts.begin(), posts.end(),
-                   compare_items<post_t>(sort_order, report));
+  if (truncator && posts.size() > 1) {
+    post_leading_posts();
+    posts.clear();
+    return;
+  }
+
+  // A single posting is never compared, and so its sort values are
+  // never computed.
+  if (posts.size() > 1) {
+    compare_items<post_t> compare(sort_order, report);
+    foreach (post_t * post, posts)
+      compare.calc_sort_values(*post);
+
+    std::size_t threads = 1;
+    if (report.HANDLED(threads_))
+      threads = lexical_cast<std::size_t>(report.HANDLER(threads_).str());
+    if (! sort_posts_by_keys(posts, threads))
+      std::stable_sort(posts.begin(), posts.end(), compare);
+  }
 
   foreach (post_t * post, posts) {
     post->xdata().drop_flags(POST_EXT_SORT_CALC);
@@ -198,6 +274,111 @@ namespace {
   }
 }
 
+namespace {
+  // Account names are built when first asked for, and remembered, so
+  // they are built before any thread might ask for them.
+  void compute_fullnames(const account_t& account)
+  {
+    account.fullname();
+    foreach (const accounts_map::value_type& pair, account.accounts)
+      compute_fullnames(*pair.second);
+  }
+
+  void test_posts(const predicate_t& pred, scope_t& context,
+                  post_t ** posts, char * passed, std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; i++)
+      passed[i] = pred.test(*posts[i], context);
+  }
+}
+
+void parallel_filter_posts::test_batch(std::vector<char>& passed)
+{
+  if (! names_known) {
+    compute_fullnames(master);
+    names_known = true;
+  }
+
+  // Cut the batch into one slice per thread, only between transactions,
+  // since the postings of a transaction may share its metadata.
+  std::size_t slices = std::min(threads, batch.size() / MIN_SLICE_SIZE);
+  std::vector<std::size_t> cuts(1, 0);
+  for (std::size_t i = 1; i < slices; i++) {
+    std::size_t cut = std::max(batch.size() / slices * i, cuts.back());
+    while (cut < batch.size() && batch[cut]->xact == batch[cut - 1]->xact)
+      cut++;
+    if (cut < batch.size() && cut > cuts.back())
+      cuts.push_back(cut);
+  }
+  cuts.push_back(batch.size());
+
+  std::vector<std::future<void> > workers;
+  try {
+    for (std::size_t i = 1; i + 1 < cuts.size(); i++) {
+      try {
+        workers.push_back(std::async(std::launch::async, test_posts,
+                                     std::cref(pred), std::ref(context),
+                                     &batch[cuts[i]], &passed[cuts[i]],
+                                     cuts[i + 1] - cuts[i]));
+      }
+      catch (const std::system_error&) {
+        test_posts(pred, context, &batch[cuts[i]], &passed[cuts[i]],
+                   cuts[i + 1] - cuts[i]);
+      }
+    }
+    test_posts(pred, context, &batch[0], &passed[0], cuts[1]);
+  }
+  catch (...) {
+    foreach (std::future<void>& worker, workers)
+      worker.wait();
+    throw;
+  }
+  foreach (std::future<void>& worker, workers)
+    worker.get();
+}
+
+void parallel_filter_posts::filter_batch()
+{
+  if (batch.empty())
+    return;
+
+  std::vector<char> passed(batch.size(), false);
+  bool              tested = false;
+
+  bind_scope_t first_scope(context, *batch.front());
+  pred.compile(first_scope);
+  if (threads > 1 && pred.is_thread_safe() && ! DO_VERIFY()) {
+    try {
+      test_batch(passed);
+      tested = true;
+    }
+    catch (const std::exception&) {
+      // The postings are tested again one by one below, so that the
+      // error is reported for the posting which caused it.
+    }
+  }
+
+  std::vector<post_t *> posts;
+  posts.swap(batch);
+  for (std::size_t i = 0; i < posts.size(); i++) {
+    post_t& post(*posts[i]);
+    try {
+      if (! tested) {
+        bind_scope_t bound_scope(context, post);
+        passed[i] = pred(bound_scope);
+      }
+      if (passed[i]) {
+        post.xdata().add_flags(POST_EXT_MATCHES);
+        (*handler)(post);
+      }
+    }
+    catch (const std::exception&) {
+      add_error_context(item_context(post, _("While handling posting")));
+      throw;
+    }
+  }
+}
+
 void anonymize_posts::render_commodity(amount_t& amt)
 {
   commodity_t& comm(amt.commodity());
@@ -875,16 +1056,60 @@ void subtotal_posts::report_subtotal(const char *                     spec_fmt,
   xact.payee = out_date.str();
   xact._date = *range_start;
 
-  foreach (values_map::value_type& pair, values)
-    handle_value(/* value=      */ pair.second.value,
-                 /* account=    */ pair.second.account,
+  values_list sorted(values_by_name());
+  foreach (acct_value_t& value, sorted)
+    handle_value(/* value=      */ value.value,
+                 /* account=    */ value.account,
                  /* xact=       */ &xact,
                  /* temps=      */ temps,
                  /* handler=    */ handler,
                  /* date=       */ *range_finish,
                  /* act_date_p= */ false);
 
-  values.clear();
+  clear_values();
+}
+
+namespace {
+  typedef std::pair<string, std::size_t> named_position_t;
+
+  struct sort_by_name {
+    bool operator()(const named_position_t& left,
+                    const named_position_t& right) const {
+      return left.first < right.first;
+    }
+  };
+
+  void check_virtual(const bool is_virtual, const bool other_is_virtual)
+  {
+    if (is_virtual != other_is_virtual)
+      throw_(std::logic_error,
+             _("'equity' cannot accept virtual and "
+               "non-virtual postings to the same account"));
+  }
+}
+
+subtotal_posts::values_list subtotal_posts::values_by_name() const
+{
+  std::vector<named_position_t> names;
+  names.reserve(values.size());
+  for (std::size_t i = 0; i < values.size(); i++)
+    names.push_back(named_position_t(values[i].account->fullname(), i));
+  std::stable_sort(names.begin(), names.end(), sort_by_name());
+
+  values_list sorted;
+  sorted.reserve(values.size());
+  const string * last_name = NULL;
+  foreach (const named_position_t& name, names) {
+    const acct_value_t& value(values[name.second]);
+    if (last_name && *last_name == name.first) {
+      check_virtual(value.is_virtual, sorted.back().is_virtual);
+      add_or_set_value(sorted.back().value, value.value);
+    } else {
+      sorted.push_back(value);
+      last_name = &name.first;
+    }
+  }
+  return sorted;
 }
 
 void subtotal_posts::operator()(post_t& post)
@@ -908,25 +1133,16 @@ void subtotal_posts::operator()(post_t& post)
   post.xdata().compound_value = amount;
   post.xdata().add_flags(POST_EXT_COMPOUND);
 
-  values_map::iterator i = values.find(acct->fullname());
-  if (i == values.end()) {
-#if DEBUG_ON
-    std::pair<values_map::iterator, bool> result =
-#endif
-      values.insert(values_pair
-                    (acct->fullname(),
-                     acct_value_t(acct, amount, post.has_flags(POST_VIRTUAL),
-                                  post.has_flags(POST_MUST_BALANCE))));
-#if DEBUG_ON
-    assert(result.second);
-#endif
+  std::pair<positions_map::iterator, bool> result =
+    positions.insert(positions_map::value_type(acct, values.size()));
+  if (result.second) {
+    values.push_back(acct_value_t(acct, amount, post.has_flags(POST_VIRTUAL),
+                                  post.has_flags(POST_MUST_BALANCE)));
   } else {
-    if (post.has_flags(POST_VIRTUAL) != (*i).second.is_virtual)
-      throw_(std::logic_error,
-             _("'equity' cannot accept virtual and "
-               "non-virtual postings to the same account"));
+    acct_value_t& value(values[(*result.first).second]);
+    check_virtual(post.has_flags(POST_VIRTUAL), value.is_virtual);
 
-    add_or_set_value((*i).second.value, amount);
+    add_or_set_value(value.value, amount);
   }
 
   // If the account for this post is all virtual, mark it as
@@ -1096,15 +1312,16 @@ void posts_as_equity::report_subtotal()
   xact._date = finish;
 
   value_t total = 0L;
-  foreach (values_map::value_type& pair, values) {
-    value_t value(pair.second.value.strip_annotations(report.what_to_keep()));
+  values_list sorted(values_by_name());
+  foreach (acct_value_t& acct_value, sorted) {
+    value_t value(acct_value.value.strip_annotations(report.what_to_keep()));
     if (! value.is_zero()) {
       if (value.is_balance()) {
         foreach (const balance_t::amounts_map::value_type& amount_pair,
                  value.as_balance_lval().amounts) {
           if (! amount_pair.second.is_zero())
             handle_value(/* value=      */ amount_pair.second,
-                         /* account=    */ pair.second.account,
+                         /* account=    */ acct_value.account,
                          /* xact=       */ &xact,
                          /* temps=      */ temps,
                          /* handler=    */ handler,
@@ -1113,7 +1330,7 @@ void posts_as_equity::report_subtotal()
         }
       } else {
         handle_value(/* value=      */ value.to_amount(),
-                     /* account=    */ pair.second.account,
+                     /* account=    */ acct_value.account,
                      /* xact=       */ &xact,
                      /* temps=      */ temps,
                      /* handler=    */ handler,
@@ -1122,10 +1339,10 @@ void posts_as_equity::report_subtotal()
       }
     }
 
-    if (! pair.second.is_virtual || pair.second.must_balance)
+    if (! acct_value.is_virtual || acct_value.must_balance)
       total += value;
   }
-  values.clear();
+  clear_values();
 
   // This last part isn't really needed, since an Equity:Opening
   // Balances posting with a null amount will automatically balance with
@@ -1141,9 +1358,23 @@ void posts_as_equity::report_subtotal()
   }
 }
 
+namespace {
+  struct sort_by_payee {
+    typedef std::pair<string, shared_ptr<subtotal_posts> > subtotals_pair;
+
+    bool operator()(const subtotals_pair& left,
+                    const subtotals_pair& right) const {
+      return left.first < right.first;
+    }
+  };
+}
+
 void by_payee_posts::flush()
 {
-  foreach (payee_subtotals_map::value_type& pair, payee_subtotals)
+  std::vector<payee_subtotals_pair> subtotals(payee_subtotals.begin(),
+                                              payee_subtotals.end());
+  std::sort(subtotals.begin(), subtotals.end(), sort_by_payee());
+  foreach (payee_subtotals_pair& pair, subtotals)
     pair.second->report_subtotal(pair.first.c_str());
 
   item_handler<post_t>::flush();
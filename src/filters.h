@@ -221,6 +221,11 @@ public:
   virtual void flush();
   virtual void operator()(post_t& post);
 
+  // Whether every later posting would be dropped.
+  bool finished() const {
+    return completed;
+  }
+
   virtual void clear() {
     completed = false;
     posts.clear();
@@ -235,22 +240,30 @@ class sort_posts : public item_handler<post_t>
 {
   typedef std::deque<post_t *> posts_deque;
 
-  posts_deque posts;
-  expr_t      sort_order;
-  report_t&   report;
+  posts_deque      posts;
+  expr_t           sort_order;
+  report_t&        report;
+  truncate_xacts * truncator;
 
   sort_posts();
 
+  void post_leading_posts();
+
 public:
   sort_posts(post_handler_ptr handler, const expr_t& _sort_order,
              report_t& _report)
-    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report) {
+    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report),
+      truncator(NULL) {
     TRACE_CTOR(sort_posts, "post_handler_ptr, const value_expr&, report_t&");
   }
+  // If `_truncator' is given, posts are only sorted until it needs no
+  // more of them.
   sort_posts(post_handler_ptr handler, const string& _sort_order,
-             report_t& _report)
-    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report) {
-    TRACE_CTOR(sort_posts, "post_handler_ptr, const string&, report_t&");
+             report_t& _report, truncate_xacts * _truncator = NULL)
+    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report),
+      truncator(_truncator) {
+    TRACE_CTOR(sort_posts,
+               "post_handler_ptr, const string&, report_t&, truncate_xacts *");
   }
   virtual ~sort_posts() {
     TRACE_DTOR(sort_posts);
@@ -353,6 +366,65 @@ public:
   }
 };
 
+/**
+ * Passes on the same postings as filter_posts, but tests them in
+ * batches, several threads at once.  Each thread takes whole
+ * transactions, and the postings which pass are handed on from the
+ * calling thread, in the order they arrived.  Predicates that are not
+ * predicate_t::is_thread_safe() are tested one posting at a time, as by
+ * filter_posts.
+ */
+class parallel_filter_posts : public item_handler<post_t>
+{
+  predicate_t           pred;
+  scope_t&              context;
+  account_t&            master;
+  std::size_t           threads;
+  bool                  names_known;
+  std::vector<post_t *> batch;
+
+  static const std::size_t BATCH_SIZE      = 8192;
+  static const std::size_t MIN_SLICE_SIZE  = 256;
+
+  parallel_filter_posts();
+
+  void test_batch(std::vector<char>& passed);
+
+public:
+  parallel_filter_posts(post_handler_ptr   handler,
+                        const predicate_t& predicate,
+                        scope_t&           _context,
+                        account_t&         _master,
+                        std::size_t        _threads)
+    : item_handler<post_t>(handler), pred(predicate), context(_context),
+      master(_master), threads(_threads), names_known(false) {
+    TRACE_CTOR(parallel_filter_posts, "post_handler_ptr, predicate_t, "
+               "scope_t&, account_t&, std::size_t");
+  }
+  virtual ~parallel_filter_posts() {
+    TRACE_DTOR(parallel_filter_posts);
+  }
+
+  void filter_batch();
+
+  virtual void flush() {
+    filter_batch();
+    item_handler<post_t>::flush();
+  }
+
+  virtual void operator()(post_t& post) {
+    batch.push_back(&post);
+    if (batch.size() >= BATCH_SIZE)
+      filter_batch();
+  }
+
+  virtual void clear() {
+    batch.clear();
+    pred.mark_uncompiled();
+    item_handler<post_t>::clear();
+  }
+};
+
 class anonymize_posts : public item_handler<post_t>
 {
   typedef std::map<commodity_t *, std::size_t>        commodity_index_map;
@@ -604,6 +676,9 @@ public:
 
   virtual ~changed_value_posts() {
     TRACE_DTOR(changed_value_posts);
+    // Our postings may refer to accounts owned by display_filter, which
+    // is destroyed along with the handler chain.
+    temps.clear();
     handler.reset();
   }
 
@@ -669,16 +744,29 @@ protected:
     }
   };
 
-  typedef std::map<string, acct_value_t>  values_map;
-  typedef std::pair<string, acct_value_t> values_pair;
+  // Subtotals are kept in the order their accounts were first seen, and
+  // found through a hash of the account, so that account names are only
+  // compared once, by values_by_name().
+  typedef std::vector<acct_value_t>                   values_list;
+  typedef std::unordered_map<account_t *, std::size_t> positions_map;
 
 protected:
   expr_t&              amount_expr;
-  values_map           values;
+  values_list          values;
+  positions_map        positions;
   optional<string>     date_format;
   temporaries_t        temps;
   std::deque<post_t *> component_posts;
 
+  // The subtotals sorted by account name.  Accounts sharing a full name,
+  // such as temporary ones, are subtotaled together.
+  values_list values_by_name() const;
+
+  void clear_values() {
+    values.clear();
+    positions.clear();
+  }
+
 public:
   subtotal_posts(post_handler_ptr handler, expr_t& _amount_expr,
                  const optional<string>& _date_format = none)
@@ -704,7 +792,7 @@ public:
 
   virtual void clear() {
     amount_expr.mark_uncompiled();
-    values.clear();
+    clear_values();
     temps.clear();
     component_posts.clear();
 
@@ -814,7 +902,8 @@ public:
 
 class by_payee_posts : public item_handler<post_t>
 {
-  typedef std::map<string, shared_ptr<subtotal_posts> >  payee_subtotals_map;
+  typedef std::unordered_map<string, shared_ptr<subtotal_posts> >
+    payee_subtotals_map;
   typedef std::pair<string, shared_ptr<subtotal_posts> > payee_subtotals_pair;
 
   expr_t&             amount_expr;
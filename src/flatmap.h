@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @addtogroup util
+ */
+
+/**
+ * @file   flatmap.h
+ * @author John Wiegley
+ *
+ * @ingroup util
+ *
+ * @brief A sorted-vector map which keeps its first few entries inline.
+ *
+ * flat_map offers the subset of std::map that balance_t needs.  Entries
+ * are kept in a contiguous array sorted by key, so they are visited in
+ * the same order as in a std::map with the same comparison.  Up to N
+ * entries live inside the object itself; only beyond that is an array
+ * allocated on the heap.
+ *
+ * As with std::vector, inserting or erasing an entry invalidates all
+ * iterators into the map.
+ */
+#ifndef _FLATMAP_H
+#define _FLATMAP_H
+
+namespace ledger {
+
+template <typename Key, typename T, std::size_t N = 4,
+          typename Compare = std::less<Key> >
+class flat_map
+{
+public:
+  typedef Key                      key_type;
+  typedef T                        mapped_type;
+  typedef std::pair<Key, T>        value_type;
+  typedef value_type *             iterator;
+  typedef const value_type *       const_iterator;
+  typedef std::size_t              size_type;
+
+protected:
+  typedef typename std::aligned_storage<sizeof(value_type),
+                                        alignof(value_type)>::type slot_t;
+
+  value_type * entries;
+  size_type    count;
+  size_type    capacity;
+  slot_t       local[N];
+
+  value_type * local_entries() {
+    return reinterpret_cast<value_type *>(local);
+  }
+  bool is_local() const {
+    return entries == reinterpret_cast<const value_type *>(local);
+  }
+
+  void destroy_all() {
+    for (size_type i = 0; i < count; i++)
+      entries[i].~value_type();
+    count = 0;
+  }
+
+  void grow(size_type wanted) {
+    if (wanted <= capacity)
+      return;
+
+    size_type new_capacity = std::max(wanted, capacity * 2);
+    value_type * new_entries = static_cast<value_type *>
+      (::operator new(new_capacity * sizeof(value_type)));
+
+    size_type i = 0;
+    try {
+      for (; i < count; i++)
+        ::new (new_entries + i) value_type(std::move(entries[i]));
+    }
+    catch (...) {
+      while (i > 0)
+        new_entries[--i].~value_type();
+      ::operator delete(new_entries);
+      throw;
+    }
+
+    size_type old_count = count;
+    destroy_all();
+    if (! is_local())
+      ::operator delete(entries);
+
+    entries  = new_entries;
+    count    = old_count;
+    capacity = new_capacity;
+  }
+
+public:
+  flat_map() : entries(local_entries()), count(0), capacity(N) {}
+  flat_map(const flat_map& other)
+    : entries(local_entries()), count(0), capacity(N) {
+    *this = other;
+  }
+  ~flat_map() {
+    destroy_all();
+    if (! is_local())
+      ::operator delete(entries);
+  }
+
+  flat_map& operator=(const flat_map& other) {
+    if (this != &other) {
+      clear();
+      grow(other.count);
+      for (; count < other.count; count++)
+        ::new (entries + count) value_type(other.entries[count]);
+    }
+    return *this;
+  }
+
+  iterator begin() { return entries; }
+  iterator end() { return entries + count; }
+  const_iterator begin() const { return entries; }
+  const_iterator end() const { return entries + count; }
+
+  size_type size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  void clear() {
+    destroy_all();
+  }
+
+  iterator lower_bound(const key_type& key) {
+    return const_cast<iterator>
+      (static_cast<const flat_map&>(*this).lower_bound(key));
+  }
+  const_iterator lower_bound(const key_type& key) const {
+    const_iterator first = begin();
+    size_type      len   = count;
+    while (len > 0) {
+      size_type half = len / 2;
+      if (Compare()(first[half].first, key)) {
+        first += half + 1;
+        len   -= half + 1;
+      } else {
+        len = half;
+      }
+    }
+    return first;
+  }
+
+  iterator find(const key_type& key) {
+    iterator i = lower_bound(key);
+    return (i != end() && ! Compare()(key, i->first)) ? i : end();
+  }
+  const_iterator find(const key_type& key) const {
+    const_iterator i = lower_bound(key);
+    return (i != end() && ! Compare()(key, i->first)) ? i : end();
+  }
+
+  /** Like std::map::insert, this does nothing if the key is present. */
+  std::pair<iterator, bool> insert(const value_type& value) {
+    size_type pos = static_cast<size_type>(lower_bound(value.first) - begin());
+    if (pos < count && ! Compare()(value.first, entries[pos].first))
+      return std::pair<iterator, bool>(entries + pos, false);
+
+    grow(count + 1);
+
+    if (pos == count) {
+      ::new (entries + count) value_type(value);
+    } else {
+      ::new (entries + count) value_type(std::move(entries[count - 1]));
+      std::move_backward(entries + pos, entries + count - 1,
+                         entries + count);
+      entries[pos] = value;
+    }
+    count++;
+
+    return std::pair<iterator, bool>(entries + pos, true);
+  }
+
+  iterator erase(iterator pos) {
+    std::move(pos + 1, end(), pos);
+    entries[--count].~value_type();
+    return pos;
+  }
+};
+
+} // namespace ledger
+
+#endif // _FLATMAP_H
@@ -196,6 +196,9 @@ void global_scope_t::execute_command(strings_list args, bool at_repl)
   strings_list::iterator arg  = args.begin();
   string                 verb = *arg++;
 
+  // --explain-expr covers the expressions of this command only
+  expr_t::explain_stream = report().HANDLED(explain_expr) ? &std::cerr : NULL;
+
   // Look for a precommand first, which is defined as any defined function
   // whose name starts with "ledger_precmd_".  The difference between a
   // precommand and a regular command is that precommands ignore the journal
@@ -222,11 +225,17 @@ void global_scope_t::execute_command(strings_list args, bool at_repl)
   // report options based on the command verb.
 
   if (! is_precommand) {
-    if (! at_repl)
+    // With --stream, reading the journal is put off until the options
+    // are known, so that a register report can read it itself.
+    bool stream = ! at_repl && report().HANDLED(stream);
+    if (! at_repl && ! stream)
       session().read_journal_files();
 
     report().normalize_options(verb);
 
+    if (stream && ! report().can_stream_journal(verb))
+      session().read_journal_files();
+
     if (! bool(command = look_for_command(bound_scope, verb)))
       throw_(std::logic_error, _f("Unrecognized command '%1%'") % verb);
   }
@@ -270,6 +279,7 @@ int global_scope_t::execute_command_wrapper(strings_list args, bool at_repl)
     if (at_repl) push_report();
     execute_command(args, at_repl);
     if (at_repl) pop_report();
+    expr_t::explain_stream = NULL;
 
     // If we've reached this point, everything succeeded fine.  Ledger uses
     // exceptions to notify of error conditions, so if you're using gdb,
@@ -278,6 +288,7 @@ int global_scope_t::execute_command_wrapper(strings_list args, bool at_repl)
   }
   catch (const std::exception& err) {
     if (at_repl) pop_report();
+    expr_t::explain_stream = NULL;
     report_error(err);
   }
 
@@ -110,6 +110,10 @@ public:
                   const datetime_t&  _oldest = datetime_t(),
                   bool bidirectionally = false);
 
+  void map_all_prices(function<void(const commodity_t& source,
+                                    const datetime_t&  when,
+                                    const amount_t&    price)> fn);
+
   optional<price_point_t>
   find_price(const commodity_t& source,
              const datetime_t&  moment,
@@ -162,6 +166,12 @@ void commodity_history_t::map_prices(
   p_impl->map_prices(fn, source, moment, _oldest, bidirectionally);
 }
 
+void commodity_history_t::map_all_prices(
+  function<void(const commodity_t&, const datetime_t&, const amount_t&)> fn)
+{
+  p_impl->map_all_prices(fn);
+}
+
 optional<price_point_t>
 commodity_history_t::find_price(const commodity_t& source,
                                 const datetime_t&  moment,
@@ -367,6 +377,23 @@ void commodity_history_impl_t::map_prices(
   }
 }
 
+void commodity_history_impl_t::map_all_prices(
+  function<void(const commodity_t&, const datetime_t&, const amount_t&)> fn)
+{
+  NameMap namemap(get(vertex_name, price_graph));
+
+  graph_traits<Graph>::edge_iterator ei, eend;
+  for (boost::tuples::tie(ei, eend) = edges(price_graph); ei != eend; ++ei) {
+    const commodity_t * sc = get(namemap, boost::source(*ei, price_graph));
+    const commodity_t * tc = get(namemap, boost::target(*ei, price_graph));
+
+    // Each price is stored on the undirected edge between the commodity
+    // being priced and the commodity of the price itself.
+    foreach (const price_map_t::value_type& pair, get(ratiomap, *ei))
+      fn(pair.second.commodity() == *tc ? *sc : *tc, pair.first, pair.second);
+  }
+}
+
 optional<price_point_t>
 commodity_history_impl_t::find_price(const commodity_t& source,
                                      const datetime_t&  moment,
@@ -76,6 +76,10 @@ public:
                   const datetime_t&  _oldest = datetime_t(),
                   bool bidirectionally = false);
 
+  void map_all_prices(function<void(const commodity_t& source,
+                                    const datetime_t&  when,
+                                    const amount_t&    price)> fn);
+
   boost::optional<price_point_t>
   find_price(const commodity_t& source,
              const datetime_t&  moment,
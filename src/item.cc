@@ -426,125 +426,159 @@ expr_t::ptr_op_t item_t::lookup(const symbol_t::kind_t kind,
   if (kind != symbol_t::FUNCTION)
     return NULL;
 
-  switch (name[0]) {
-  case 'a':
+  switch (hash_name(name.c_str())) {
+  case hash_name("actual"):
     if (name == "actual")
       return WRAP_FUNCTOR(get_wrapper<&get_actual>);
-    else if (name == "actual_date")
+    break;
+  case hash_name("actual_date"):
+    if (name == "actual_date")
       return WRAP_FUNCTOR(get_wrapper<&get_primary_date>);
-    else if (name == "addr")
+    break;
+  case hash_name("addr"):
+    if (name == "addr")
       return WRAP_FUNCTOR(get_wrapper<&get_addr>);
-    else if (name == "aux_date")
+    break;
+  case hash_name("aux_date"):
+    if (name == "aux_date")
       return WRAP_FUNCTOR(get_wrapper<&get_aux_date>);
     break;
 
-  case 'b':
+  case hash_name("beg_line"):
     if (name == "beg_line")
       return WRAP_FUNCTOR(get_wrapper<&get_beg_line>);
-    else if (name == "beg_pos")
+    break;
+  case hash_name("beg_pos"):
+    if (name == "beg_pos")
       return WRAP_FUNCTOR(get_wrapper<&get_beg_pos>);
     break;
 
-  case 'c':
+  case hash_name("cleared"):
     if (name == "cleared")
       return WRAP_FUNCTOR(get_wrapper<&get_cleared>);
-    else if (name == "comment")
+    break;
+  case hash_name("comment"):
+    if (name == "comment")
       return WRAP_FUNCTOR(get_wrapper<&get_comment>);
     break;
 
-  case 'd':
+  case hash_name("d"):
+  case hash_name("date"):
     if (name[1] == '\0' || name == "date")
       return WRAP_FUNCTOR(get_wrapper<&get_date>);
-    else if (name == "depth")
+    break;
+  case hash_name("depth"):
+    if (name == "depth")
       return WRAP_FUNCTOR(get_wrapper<&get_depth>);
     break;
 
-  case 'e':
+  case hash_name("end_line"):
     if (name == "end_line")
       return WRAP_FUNCTOR(get_wrapper<&get_end_line>);
-    else if (name == "end_pos")
+    break;
+  case hash_name("end_pos"):
+    if (name == "end_pos")
       return WRAP_FUNCTOR(get_wrapper<&get_end_pos>);
-    else if (name == "effective_date")
+    break;
+  case hash_name("effective_date"):
+    if (name == "effective_date")
       return WRAP_FUNCTOR(get_wrapper<&get_aux_date>);
     break;
 
-  case 'f':
+  case hash_name("filename"):
     if (name == "filename")
       return WRAP_FUNCTOR(get_wrapper<&get_pathname>);
-    else if (name == "filebase")
+    break;
+  case hash_name("filebase"):
+    if (name == "filebase")
       return WRAP_FUNCTOR(get_wrapper<&get_filebase>);
-    else if (name == "filepath")
+    break;
+  case hash_name("filepath"):
+    if (name == "filepath")
       return WRAP_FUNCTOR(get_wrapper<&get_filepath>);
-     break;
+    break;
 
-  case 'h':
+  case hash_name("has_tag"):
     if (name == "has_tag")
       return WRAP_FUNCTOR(ledger::has_tag);
-    else if (name == "has_meta")
+    break;
+  case hash_name("has_meta"):
+    if (name == "has_meta")
       return WRAP_FUNCTOR(ledger::has_tag);
     break;
 
-  case 'i':
+  case hash_name("is_account"):
     if (name == "is_account")
       return WRAP_FUNCTOR(get_wrapper<&ignore>);
-    else if (name == "id")
+    break;
+  case hash_name("id"):
+    if (name == "id")
       return WRAP_FUNCTOR(get_wrapper<&get_id>);
     break;
 
-  case 'm':
+  case hash_name("meta"):
     if (name == "meta")
       return WRAP_FUNCTOR(ledger::get_tag);
     break;
 
-  case 'n':
+  case hash_name("note"):
     if (name == "note")
       return WRAP_FUNCTOR(get_wrapper<&get_note>);
     break;
 
-  case 'p':
+  case hash_name("pending"):
     if (name == "pending")
       return WRAP_FUNCTOR(get_wrapper<&get_pending>);
-    else if (name == "parent")
+    break;
+  case hash_name("parent"):
+    if (name == "parent")
       return WRAP_FUNCTOR(get_wrapper<&ignore>);
-    else if (name == "primary_date")
+    break;
+  case hash_name("primary_date"):
+    if (name == "primary_date")
       return WRAP_FUNCTOR(get_wrapper<&get_primary_date>);
     break;
 
-  case 's':
+  case hash_name("status"):
+  case hash_name("state"):
     if (name == "status" || name == "state")
       return WRAP_FUNCTOR(get_wrapper<&get_status>);
-    else if (name == "seq")
+    break;
+  case hash_name("seq"):
+    if (name == "seq")
       return WRAP_FUNCTOR(get_wrapper<&get_seq>);
     break;
 
-  case 't':
+  case hash_name("tag"):
     if (name == "tag")
       return WRAP_FUNCTOR(ledger::get_tag);
     break;
 
-  case 'u':
+  case hash_name("uncleared"):
     if (name == "uncleared")
       return WRAP_FUNCTOR(get_wrapper<&get_uncleared>);
-    else if (name == "uuid")
+    break;
+  case hash_name("uuid"):
+    if (name == "uuid")
       return WRAP_FUNCTOR(get_wrapper<&get_id>);
     break;
 
-  case 'v':
+  case hash_name("value_date"):
     if (name == "value_date")
       return WRAP_FUNCTOR(get_wrapper<&get_date>);
     break;
 
-  case 'L':
+  case hash_name("L"):
     if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_actual>);
     break;
 
-  case 'X':
+  case hash_name("X"):
     if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_cleared>);
     break;
 
-  case 'Y':
+  case hash_name("Y"):
     if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_pending>);
     break;
@@ -203,6 +203,9 @@ public:
                       expr_t::ptr_op_t);
   virtual expr_t::ptr_op_t lookup(const symbol_t::kind_t kind,
                                   const string& name);
+  virtual bool lookup_by_type() const {
+    return true;
+  }
 
   bool valid() const;
 };
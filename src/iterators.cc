@@ -57,10 +57,31 @@ void xacts_iterator::increment()
 
 void journal_posts_iterator::reset(journal_t& journal)
 {
+  selected.reset();
+  selected_posts.reset();
   xacts.reset(journal);
   increment();
 }
 
+void journal_posts_iterator::reset(const xacts_list& xacts_to_visit)
+{
+  selected.reset(new xacts_list(xacts_to_visit));
+  selected_posts.reset();
+  xacts.reset(selected->begin(), selected->end());
+  increment();
+}
+
+void journal_posts_iterator::reset(const posts_list& posts_to_visit)
+{
+  // The postings are handed out by `posts' alone, as if they all
+  // belonged to one transaction, and there are no others to move on to.
+  selected.reset(new xacts_list);
+  selected_posts.reset(new posts_list(posts_to_visit));
+  xacts.reset(selected->begin(), selected->end());
+  posts.reset(selected_posts->begin(), selected_posts->end());
+  increment();
+}
+
 void journal_posts_iterator::increment()
 {
   if (post_t * post = *posts++) {
@@ -134,11 +155,21 @@ namespace {
   };
 }
 
+namespace {
+  struct commodity_creation_order {
+    bool operator()(const commodity_t * left, const commodity_t * right) const {
+      return *left->graph_index() < *right->graph_index();
+    }
+  };
+}
+
 void posts_commodities_iterator::reset(journal_t& journal)
 {
   journal_posts.reset(journal);
 
-  std::set<commodity_t *> commodities;
+  // Commodities are visited in the order they were created, rather than
+  // in the order of their addresses.
+  std::set<commodity_t *, commodity_creation_order> commodities;
 
   while (const post_t * post = *journal_posts++) {
     commodity_t& comm(post->amount.commodity());
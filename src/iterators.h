@@ -116,8 +116,12 @@ public:
   }
 
   void reset(xact_t& xact) {
-    posts_i   = xact.posts.begin();
-    posts_end = xact.posts.end();
+    reset(xact.posts.begin(), xact.posts.end());
+  }
+
+  void reset(posts_list::iterator beg, posts_list::iterator end) {
+    posts_i   = beg;
+    posts_end = end;
 
     posts_uninitialized = false;
 
@@ -180,8 +184,10 @@ class journal_posts_iterator
   : public iterator_facade_base<journal_posts_iterator, post_t *,
                                 boost::forward_traversal_tag>
 {
-  xacts_iterator      xacts;
-  xact_posts_iterator posts;
+  xacts_iterator          xacts;
+  xact_posts_iterator     posts;
+  shared_ptr<xacts_list>  selected;
+  shared_ptr<posts_list>  selected_posts;
 
 public:
   journal_posts_iterator() {
@@ -194,7 +200,8 @@ public:
   journal_posts_iterator(const journal_posts_iterator& i)
     : iterator_facade_base<journal_posts_iterator, post_t *,
                            boost::forward_traversal_tag>(i),
-      xacts(i.xacts), posts(i.posts) {
+      xacts(i.xacts), posts(i.posts), selected(i.selected),
+      selected_posts(i.selected_posts) {
     TRACE_CTOR(journal_posts_iterator, "copy");
   }
   ~journal_posts_iterator() throw() {
@@ -203,6 +210,11 @@ public:
 
   void reset(journal_t& journal);
 
+  // Only visit the postings of the given transactions, or the given
+  // postings, instead of those of the whole journal.
+  void reset(const xacts_list& xacts_to_visit);
+  void reset(const posts_list& posts_to_visit);
+
   void increment();
 };
 
@@ -98,6 +98,10 @@ void journal_t::initialize()
   checking_style    = CHECK_NORMAL;
   recursive_aliases = false;
   no_aliases        = false;
+  cacheable         = true;
+
+  auto_xacts_edit_posts = false;
+  xacts_tagged          = 0;
 }
 
 void journal_t::add_account(account_t * acct)
@@ -135,11 +139,10 @@ account_t * journal_t::register_account(const string& name, post_t * post,
   // If the account name being registered is "Unknown", check whether
   // the payee indicates an account that should be used.
   if (result->name == _("Unknown")) {
-    foreach (account_mapping_t& value, payees_for_unknown_accounts) {
-      if (post && value.first.match(post->xact->payee)) {
-        result = value.second;
-        break;
-      }
+    if (post) {
+      if (account_mapping_t * value =
+          payees_for_unknown_accounts.find(post->xact->payee))
+        result = value->second;
     }
   }
 
@@ -249,12 +252,8 @@ string journal_t::register_payee(const string& name, xact_t * xact)
     }
   }
 
-  foreach (payee_alias_mapping_t& value, payee_alias_mappings) {
-    if (value.first.match(name)) {
-      payee = value.second;
-      break;
-    }
-  }
+  if (payee_alias_mapping_t * value = payee_alias_mappings.find(name))
+    payee = value->second;
 
   return payee.empty() ? name : payee;
 }
@@ -454,15 +453,175 @@ bool journal_t::add_xact(xact_t * xact)
     }
   }
 
-  xacts.push_back(xact);
+  if (xact_streamer)
+    stream_xact(xact);
+  else
+    xacts.push_back(xact);
 
   return true;
 }
 
+void journal_t::stream_xact(xact_t * xact)
+{
+  // Fold each posting into its account's balance before the report sees
+  // it, since later balance assertions must not pick up the values that
+  // the report leaves in the posting's xdata.
+  foreach (post_t * post, xact->posts)
+    post->account->amount();
+
+  xact_streamer(*xact);
+
+  // A transaction with a UUID may be compared against a later duplicate,
+  // and deferred postings are applied only once reading is done, so these
+  // are kept.
+  bool keep = bool(xact->get_tag(_("UUID")));
+  foreach (post_t * post, xact->posts)
+    if (post->has_flags(POST_DEFERRED))
+      keep = true;
+
+  if (keep) {
+    xacts.push_back(xact);
+    return;
+  }
+
+  streamed_xacts.push_back(xact);
+  if (streamed_xacts.size() > STREAM_WINDOW) {
+    xact_t * expired = streamed_xacts.front();
+    streamed_xacts.pop_front();
+
+    // Handlers behind a --limit, --only or --display filter remember the
+    // last posting that got through, however far back that was, such as
+    // calc_posts for the running total or format_posts for the payee.
+    // Only a transaction none of whose postings matched or was displayed
+    // can be freed; handlers ahead of the filters look back no further
+    // than the window.
+    foreach (post_t * post, expired->posts) {
+      if (post->has_xdata() &&
+          post->xdata().has_flags(POST_EXT_MATCHES | POST_EXT_DISPLAYED)) {
+        xacts.push_back(expired);
+        return;
+      }
+    }
+
+    // The account's cursor into its posts list may refer to one of the
+    // postings being removed.  Every posting left in the list has been
+    // folded already, so starting over from the beginning is safe.
+    foreach (post_t * post, expired->posts)
+      if (post->account && post->account->has_xdata())
+        post->account->xdata().self_details.last_post = none;
+
+    checked_delete(expired);
+  }
+}
+
+void journal_t::finish_streaming()
+{
+  xact_streamer.clear();
+
+  // The transactions still in the window may be referred to by the
+  // handlers until they are flushed, so the journal takes them back.
+  foreach (xact_t * xact, streamed_xacts)
+    xacts.push_back(xact);
+  streamed_xacts.clear();
+}
+
 void journal_t::extend_xact(xact_base_t * xact)
 {
-  foreach (auto_xact_t * auto_xact, auto_xacts)
-    auto_xact->extend_xact(*xact, *current_context);
+  if (auto_xacts.empty())
+    return;
+
+  // Only postings which were not generated are extended, and these are
+  // the same for every automated transaction.
+  posts_list initial_posts;
+  foreach (post_t * post, xact->posts)
+    if (! post->has_flags(ITEM_GENERATED))
+      initial_posts.push_back(post);
+  if (initial_posts.empty())
+    return;
+
+  if (auto_xacts_by_position.size() < auto_xacts.size())
+    index_auto_xacts(*initial_posts.front());
+
+  std::vector<std::size_t> candidates(unindexed_auto_xacts);
+  foreach (post_t * post, initial_posts) {
+    if (! account_auto_xacts.empty()) {
+      applying_auto_xacts_t& applying(auto_xacts_by_account[post->account]);
+      find_applying_auto_xacts(*post, account_auto_xacts, applying);
+      candidates.insert(candidates.end(), applying.positions.begin(),
+                        applying.positions.end());
+    }
+    if (! payee_auto_xacts.empty()) {
+      applying_auto_xacts_t& applying(auto_xacts_by_payee[post->payee()]);
+      find_applying_auto_xacts(*post, payee_auto_xacts, applying);
+      candidates.insert(candidates.end(), applying.positions.begin(),
+                        applying.positions.end());
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  foreach (std::size_t position, candidates)
+    auto_xacts_by_position[position]->extend_xact(*xact, *current_context);
+}
+
+void journal_t::index_auto_xacts(post_t& post)
+{
+  auto_xacts_list::iterator i = auto_xacts.begin();
+  std::advance(i, auto_xacts_by_position.size());
+
+  for (; i != auto_xacts.end(); i++) {
+    auto_xact_t * auto_xact = *i;
+    std::size_t   position  = auto_xacts_by_position.size();
+    auto_xacts_by_position.push_back(auto_xact);
+
+    // A predicate is compiled when it is first used, and only then is it
+    // known what it tests.
+    try {
+      bind_scope_t bound_scope(*scope_t::default_scope, post);
+      auto_xact->predicate(bound_scope);
+    }
+    catch (const std::exception&) {
+      add_error_context(item_context(*auto_xact,
+                                     _("While applying automated transaction")));
+      throw;
+    }
+
+    // Notes added by an automated transaction may give a posting another
+    // payee, for those which come after it.
+    if (auto_xact->predicate.tests_account_only())
+      account_auto_xacts.push_back(position);
+    else if (auto_xact->predicate.tests_payee_only() && ! auto_xacts_edit_posts)
+      payee_auto_xacts.push_back(position);
+    else
+      unindexed_auto_xacts.push_back(position);
+
+    if (auto_xact->deferred_notes || auto_xact->check_exprs)
+      auto_xacts_edit_posts = true;
+  }
+}
+
+void journal_t::find_applying_auto_xacts(post_t& post,
+                                         const std::vector<std::size_t>& indexed,
+                                         applying_auto_xacts_t& applying)
+{
+  while (applying.checked < indexed.size()) {
+    std::size_t   position  = indexed[applying.checked];
+    auto_xact_t * auto_xact = auto_xacts_by_position[position];
+
+    try {
+      bind_scope_t bound_scope(*scope_t::default_scope, post);
+      if (auto_xact->predicate(bound_scope))
+        applying.positions.push_back(position);
+    }
+    catch (const std::exception&) {
+      add_error_context(item_context(*auto_xact,
+                                     _("While applying automated transaction")));
+      throw;
+    }
+    applying.checked++;
+  }
 }
 
 bool journal_t::remove_xact(xact_t * xact)
@@ -480,9 +639,194 @@ bool journal_t::remove_xact(xact_t * xact)
   xacts.erase(i);
   xact->journal = NULL;
 
+  xacts_by_date.clear();
+  xacts_by_position.clear();
+  xacts_by_tag.clear();
+  xacts_tagged = 0;
+  xact_positions.clear();
+
   return true;
 }
 
+void journal_t::index_xacts_by_date()
+{
+  xacts_by_date.clear();
+  xacts_by_position.assign(xacts.begin(), xacts.end());
+
+  for (std::size_t position = 0; position < xacts_by_position.size();
+       position++) {
+    xact_t * xact = xacts_by_position[position];
+
+    std::size_t first = xacts_by_date.size();
+    xacts_by_date.push_back(dated_xact_t(xact->primary_date(), position));
+    if (xact->_date_aux)
+      xacts_by_date.push_back(dated_xact_t(*xact->_date_aux, position));
+    foreach (post_t * post, xact->posts) {
+      if (post->_date)
+        xacts_by_date.push_back(dated_xact_t(*post->_date, position));
+      if (post->_date_aux)
+        xacts_by_date.push_back(dated_xact_t(*post->_date_aux, position));
+    }
+
+    // Most transactions have a single date, and need only one entry.
+    std::sort(xacts_by_date.begin() + first, xacts_by_date.end());
+    xacts_by_date.erase(std::unique(xacts_by_date.begin() + first,
+                                    xacts_by_date.end()),
+                        xacts_by_date.end());
+  }
+
+  std::sort(xacts_by_date.begin(), xacts_by_date.end());
+}
+
+xacts_list journal_t::xacts_in_range(const optional<date_t>& begin,
+                                     const optional<date_t>& end)
+{
+  if (xacts_by_position.size() != xacts.size())
+    index_xacts_by_date();
+
+  std::vector<dated_xact_t>::const_iterator first = xacts_by_date.begin();
+  std::vector<dated_xact_t>::const_iterator last  = xacts_by_date.end();
+  if (begin)
+    first = std::lower_bound(first, last, dated_xact_t(*begin, 0));
+  if (end)
+    last = std::lower_bound(first, last, dated_xact_t(*end, 0));
+
+  std::vector<std::size_t> positions;
+  for (; first != last; ++first)
+    positions.push_back((*first).second);
+  std::sort(positions.begin(), positions.end());
+  positions.erase(std::unique(positions.begin(), positions.end()),
+                  positions.end());
+
+  xacts_list found;
+  foreach (std::size_t position, positions)
+    found.push_back(xacts_by_position[position]);
+  return found;
+}
+
+namespace {
+  void index_tags(const item_t& item, std::size_t position,
+                  std::map<string, std::vector<std::size_t> >& xacts_by_tag)
+  {
+    if (! item.metadata)
+      return;
+    foreach (const item_t::string_map::value_type& data, *item.metadata) {
+      std::vector<std::size_t>& positions(xacts_by_tag[data.first]);
+      if (positions.empty() || positions.back() != position)
+        positions.push_back(position);
+    }
+  }
+}
+
+void journal_t::index_xacts_by_tag()
+{
+  if (xacts_by_position.size() != xacts.size())
+    index_xacts_by_date();
+
+  xacts_by_tag.clear();
+  for (std::size_t position = 0; position < xacts_by_position.size();
+       position++) {
+    xact_t * xact = xacts_by_position[position];
+    index_tags(*xact, position, xacts_by_tag);
+    foreach (post_t * post, xact->posts)
+      index_tags(*post, position, xacts_by_tag);
+  }
+  xacts_tagged = xacts_by_position.size();
+}
+
+std::vector<string> journal_t::tag_names()
+{
+  if (xacts_tagged != xacts.size())
+    index_xacts_by_tag();
+
+  std::vector<string> names;
+  typedef std::map<string, std::vector<std::size_t> >::value_type pair_t;
+  foreach (const pair_t& pair, xacts_by_tag)
+    names.push_back(pair.first);
+  return names;
+}
+
+xacts_list
+journal_t::xacts_with_tags(const std::vector<std::vector<string> >& names)
+{
+  if (xacts_tagged != xacts.size())
+    index_xacts_by_tag();
+
+  std::vector<std::size_t> positions;
+  for (std::size_t i = 0; i < names.size(); i++) {
+    std::vector<std::size_t> tagged;
+    foreach (const string& name, names[i]) {
+      std::map<string, std::vector<std::size_t> >::const_iterator found =
+        xacts_by_tag.find(name);
+      if (found != xacts_by_tag.end())
+        tagged.insert(tagged.end(), (*found).second.begin(),
+                      (*found).second.end());
+    }
+    std::sort(tagged.begin(), tagged.end());
+    tagged.erase(std::unique(tagged.begin(), tagged.end()), tagged.end());
+
+    if (i == 0) {
+      positions.swap(tagged);
+    } else {
+      std::vector<std::size_t> both;
+      std::set_intersection(positions.begin(), positions.end(),
+                            tagged.begin(), tagged.end(),
+                            std::back_inserter(both));
+      positions.swap(both);
+    }
+  }
+
+  xacts_list found;
+  foreach (std::size_t position, positions)
+    found.push_back(xacts_by_position[position]);
+  return found;
+}
+
+posts_list
+journal_t::account_posts_in_range(const std::vector<account_t *>& accounts,
+                                  const optional<date_t>& begin,
+                                  const optional<date_t>& end)
+{
+  if (xact_positions.size() != xacts.size()) {
+    xact_positions.clear();
+    std::size_t position = 0;
+    foreach (xact_t * xact, xacts)
+      xact_positions.insert(std::pair<xact_t *, std::size_t>(xact,
+                                                             position++));
+  }
+
+  // Only the transactions are ordered here; their postings are then
+  // taken in the order they have within each one.  Postings of
+  // transactions which are not in the journal, such as those kept back
+  // for having a UUID seen before, are left out.
+  std::vector<std::pair<std::size_t, xact_t *> > found_xacts;
+  std::set<account_t *> wanted(accounts.begin(), accounts.end());
+  foreach (account_t * account, accounts) {
+    foreach (post_t * post, account->posts) {
+      std::map<xact_t *, std::size_t>::const_iterator i =
+        xact_positions.find(post->xact);
+      if (i != xact_positions.end())
+        found_xacts.push_back(std::pair<std::size_t, xact_t *>
+                              ((*i).second, (*i).first));
+    }
+  }
+  std::sort(found_xacts.begin(), found_xacts.end());
+  found_xacts.erase(std::unique(found_xacts.begin(), found_xacts.end()),
+                    found_xacts.end());
+
+  posts_list found;
+  for (std::size_t i = 0; i < found_xacts.size(); i++) {
+    foreach (post_t * post, found_xacts[i].second->posts) {
+      if (wanted.find(post->account) == wanted.end())
+        continue;
+      date_t date = post->date();
+      if ((! begin || date >= *begin) && (! end || date < *end))
+        found.push_back(post);
+    }
+  }
+  return found;
+}
+
 std::size_t journal_t::read(parse_context_stack_t& context)
 {
   std::size_t count = 0;
@@ -503,11 +847,24 @@ std::size_t journal_t::read(parse_context_stack_t& context)
       current.master = master;
 
     count = read_textual(context);
-    if (count > 0) {
-      if (! current.pathname.empty())
+
+    // Record every regular file read, even one holding only prices or
+    // directives, so that the journal cache can tell when it changes.
+    if (! current.pathname.empty()) {
+      if (count > 0 || is_regular_file(current.pathname)) {
         sources.push_back(fileinfo_t(current.pathname));
-      else
-        sources.push_back(fileinfo_t());
+        if (current.mapping) {
+          fileinfo_t& info(sources.back());
+          info.offset    = current.mapping->size();
+          info.linenum   = current.linenum;
+          info.sequence  = current.sequence;
+          info.hash      = current.content_hash;
+          info.resumable = current.resumable;
+        }
+      }
+    }
+    else if (count > 0) {
+      sources.push_back(fileinfo_t());
     }
   }
   catch (...) {
@@ -518,8 +875,9 @@ std::size_t journal_t::read(parse_context_stack_t& context)
 
   // xdata may have been set for some accounts and transaction due to the use
   // of balance assertions or other calculations performed in valexpr-based
-  // posting amounts.
-  clear_xdata();
+  // posting amounts.  While streaming, the report is still using it.
+  if (! xact_streamer)
+    clear_xdata();
 
   return count;
 }
@@ -58,15 +58,16 @@ class account_t;
 class parse_context_t;
 class parse_context_stack_t;
 
+typedef std::list<post_t *>              posts_list;
 typedef std::list<xact_t *>              xacts_list;
 typedef std::list<auto_xact_t *>         auto_xacts_list;
 typedef std::list<period_xact_t *>       period_xacts_list;
 typedef std::pair<mask_t, string>        payee_alias_mapping_t;
-typedef std::list<payee_alias_mapping_t> payee_alias_mappings_t;
+typedef mask_table_t<string>             payee_alias_mappings_t;
 typedef std::pair<string, string>        payee_uuid_mapping_t;
 typedef std::list<payee_uuid_mapping_t>  payee_uuid_mappings_t;
 typedef std::pair<mask_t, account_t *>   account_mapping_t;
-typedef std::list<account_mapping_t>     account_mappings_t;
+typedef mask_table_t<account_t *>        account_mappings_t;
 typedef std::map<string, account_t *>    accounts_map;
 typedef std::map<string, xact_t *>       checksum_map_t;
 
@@ -82,18 +83,31 @@ public:
     datetime_t     modtime;
     bool           from_stream;
 
-    fileinfo_t() : size(0), from_stream(true) {
+    // Where the textual parser stopped in a top-level file, so that a
+    // reload can parse only what has since been appended to it.
+    uintmax_t      offset;
+    std::size_t    linenum;
+    std::size_t    sequence;
+    uint_least64_t hash;
+    bool           resumable;
+
+    fileinfo_t() : size(0), from_stream(true), offset(0), linenum(0),
+                   sequence(0), hash(0), resumable(false) {
       TRACE_CTOR(journal_t::fileinfo_t, "");
     }
     fileinfo_t(const path& _filename)
-      : filename(_filename), from_stream(false) {
+      : filename(_filename), from_stream(false), offset(0), linenum(0),
+        sequence(0), hash(0), resumable(false) {
       size    = file_size(*filename);
       modtime = posix_time::from_time_t(last_write_time(*filename));
       TRACE_CTOR(journal_t::fileinfo_t, "const path&");
     }
     fileinfo_t(const fileinfo_t& info)
       : filename(info.filename), size(info.size),
-        modtime(info.modtime), from_stream(info.from_stream)
+        modtime(info.modtime), from_stream(info.from_stream),
+        offset(info.offset), linenum(info.linenum),
+        sequence(info.sequence), hash(info.hash),
+        resumable(info.resumable)
     {
       TRACE_CTOR(journal_t::fileinfo_t, "copy");
     }
@@ -120,6 +134,7 @@ public:
   bool                   day_break;
   bool                   recursive_aliases;
   bool                   no_aliases;
+  bool                   cacheable; // false after side-effecting directives
   payee_alias_mappings_t payee_alias_mappings;
   payee_uuid_mappings_t  payee_uuid_mappings;
   account_mappings_t     account_mappings;
@@ -130,6 +145,16 @@ public:
   optional<expr_t>       value_expr;
   parse_context_t *      current_context;
 
+  // When set, each transaction is handed to this function as soon as it
+  // is added.  Unless the report matched or displayed one of its
+  // postings, it is freed a few transactions later rather than being
+  // kept in `xacts'.  This is how --stream reports the journal while it
+  // is being read.
+  function<void(xact_t&)> xact_streamer;
+  std::deque<xact_t *>    streamed_xacts;
+
+  static const std::size_t STREAM_WINDOW = 4;
+
   enum checking_style_t {
     CHECK_PERMISSIVE,
     CHECK_NORMAL,
@@ -172,6 +197,9 @@ public:
   void extend_xact(xact_base_t * xact);
   bool remove_xact(xact_t * xact);
 
+  void stream_xact(xact_t * xact);
+  void finish_streaming();
+
   xacts_list::iterator xacts_begin() {
     return xacts.begin();
   }
@@ -191,6 +219,25 @@ public:
     return period_xacts.end();
   }
 
+  // The transactions, in the order they were read, having a date (of
+  // their own or of a posting, primary or auxiliary) in [begin, end).
+  xacts_list xacts_in_range(const optional<date_t>& begin,
+                            const optional<date_t>& end);
+
+  // The names of the tags carried by any transaction or posting.
+  std::vector<string> tag_names();
+
+  // The transactions, in the order they were read, carrying a tag from
+  // each of the given lists of names, either themselves or on one of
+  // their postings.
+  xacts_list xacts_with_tags(const std::vector<std::vector<string> >& names);
+
+  // The postings of the given accounts dated within [begin, end), in the
+  // order they were read.
+  posts_list account_posts_in_range(const std::vector<account_t *>& accounts,
+                                    const optional<date_t>& begin,
+                                    const optional<date_t>& end);
+
   std::size_t read(parse_context_stack_t& context);
 
   bool has_xdata();
@@ -200,6 +247,62 @@ public:
 
 private:
   std::size_t read_textual(parse_context_stack_t& context);
+
+  // Automated transactions whose predicates test nothing but the account,
+  // or nothing but the payee, of a posting are remembered for each
+  // account and payee they apply to.  extend_xact then only needs to try
+  // those, and the ones it cannot index.
+  struct applying_auto_xacts_t {
+    std::size_t              checked;   // indexed ones looked at so far
+    std::vector<std::size_t> positions; // in auto_xacts, of those applying
+
+    applying_auto_xacts_t() : checked(0) {
+      TRACE_CTOR(journal_t::applying_auto_xacts_t, "");
+    }
+    applying_auto_xacts_t(const applying_auto_xacts_t& other)
+      : checked(other.checked), positions(other.positions) {
+      TRACE_CTOR(journal_t::applying_auto_xacts_t, "copy");
+    }
+    ~applying_auto_xacts_t() throw() {
+      TRACE_DTOR(journal_t::applying_auto_xacts_t);
+    }
+  };
+
+  std::vector<auto_xact_t *>                   auto_xacts_by_position;
+  std::vector<std::size_t>                     account_auto_xacts;
+  std::vector<std::size_t>                     payee_auto_xacts;
+  std::vector<std::size_t>                     unindexed_auto_xacts;
+  bool                                         auto_xacts_edit_posts;
+  std::map<account_t *, applying_auto_xacts_t> auto_xacts_by_account;
+  std::map<string, applying_auto_xacts_t>      auto_xacts_by_payee;
+
+  // Every date of every transaction, paired with the transaction's
+  // position in `xacts' and sorted, so that xacts_in_range can find
+  // those within a few months of a long journal without visiting the
+  // rest.  It is rebuilt whenever `xacts' has changed size.
+  typedef std::pair<date_t, std::size_t> dated_xact_t;
+
+  std::vector<dated_xact_t>                    xacts_by_date;
+  std::vector<xact_t *>                        xacts_by_position;
+
+  void index_xacts_by_date();
+
+  // For each tag name, the positions in `xacts' of the transactions
+  // carrying it, themselves or on one of their postings.  It is rebuilt
+  // with the index by date.
+  std::map<string, std::vector<std::size_t> >  xacts_by_tag;
+  std::size_t                                  xacts_tagged;
+
+  void index_xacts_by_tag();
+
+  // The position in `xacts' of each transaction, for putting postings
+  // gathered from accounts back into the order they were read.
+  std::map<xact_t *, std::size_t>              xact_positions;
+
+  void index_auto_xacts(post_t& post);
+  void find_applying_auto_xacts(post_t& post,
+                                const std::vector<std::size_t>& indexed,
+                                applying_auto_xacts_t& applying);
 };
 
 } // namespace ledger
@@ -35,7 +35,169 @@
 
 namespace ledger {
 
-mask_t::mask_t(const string& pat) : expr()
+namespace {
+  inline char fold(const char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+  }
+
+  bool equal_folded(const char * text, const char * lit, std::size_t len)
+  {
+    for (; len > 0; --len)
+      if (fold(*text++) != *lit++)
+        return false;
+    return true;
+  }
+
+  // An escaped punctuation character stands for itself, except for the
+  // word and buffer boundaries \<, \>, \` and \'.
+  bool is_escaped_literal(const char c)
+  {
+    return (c >= ' ' && c <= '~' &&
+            ! std::isalnum(static_cast<unsigned char>(c)) &&
+            c != '<' && c != '>' && c != '`' && c != '\'');
+  }
+
+  // Escapes such as \x41, \x{41}, \cA, \0101 or \N{...} stand for a
+  // character spelled by the text which follows them, and \Q quotes
+  // text; \1 and up refer back to a group.  None of these can be read
+  // one character at a time.
+  bool is_escape_with_argument(const char c)
+  {
+    return ((c >= '0' && c <= '9') || c == 'x' || c == 'c' || c == 'o' ||
+            c == 'N' || c == 'p' || c == 'P' || c == 'g' || c == 'k' ||
+            c == 'Q' || c == 'E');
+  }
+
+  // Only ASCII text is considered, since masks ignore case and the
+  // Unicode case folding rules are left to the regex library.
+  bool parse_plain_pattern(const string& pat, string& text,
+                           bool& at_begin, bool& at_end)
+  {
+    string::size_type len = pat.length();
+    string::size_type i   = 0;
+    if (len > 0 && pat[0] == '^') {
+      at_begin = true;
+      i++;
+    }
+    for (; i < len; i++) {
+      char c = pat[i];
+      if (c < ' ' || c > '~')
+        return false;
+
+      switch (c) {
+      case '$':
+        if (i + 1 < len)
+          return false;
+        at_end = true;
+        break;
+
+      case '\\':
+        if (++i == len || ! is_escaped_literal(pat[i]))
+          return false;
+        text += fold(pat[i]);
+        break;
+
+      case '.': case '^': case '|': case '(': case ')':
+      case '[': case ']': case '{': case '}':
+      case '*': case '+': case '?':
+        return false;
+
+      default:
+        text += fold(c);
+        break;
+      }
+    }
+    return true;
+  }
+
+  // The longest run of plain text which every match of a regex must
+  // contain, or an empty string if none can be told.  Only text outside
+  // of groups counts, and patterns with alternatives or (?...) groups,
+  // which may change the meaning of what follows, are given up on.
+  string required_text(const string& pat)
+  {
+    if (pat.find('|') != string::npos || pat.find("(?") != string::npos)
+      return empty_string;
+
+    string            longest;
+    string            text;
+    int               depth = 0;
+    string::size_type len   = pat.length();
+
+    for (string::size_type i = 0; i < len; i++) {
+      char c       = pat[i];
+      bool literal = false;
+
+      switch (c) {
+      case '\\':
+        if (++i == len || is_escape_with_argument(pat[i]))
+          return empty_string;
+        c       = pat[i];
+        literal = is_escaped_literal(c);
+        break;
+
+      case '[': {
+        string::size_type j = i + 1;
+        if (j < len && pat[j] == '^')
+          j++;
+        if (j < len && pat[j] == ']')
+          j++;
+        for (; j < len && pat[j] != ']'; j++) {
+          if (pat[j] == '[')
+            return empty_string;
+          if (pat[j] == '\\')
+            j++;
+        }
+        if (j >= len)
+          return empty_string;
+        i = j;
+        break;
+      }
+
+      case '{':
+        i = pat.find('}', i);
+        if (i == string::npos)
+          return empty_string;
+        break;
+
+      case '(':
+        depth++;
+        break;
+      case ')':
+        if (--depth < 0)
+          return empty_string;
+        break;
+
+      case '.': case '^': case '$': case ']': case '}':
+      case '*': case '+': case '?':
+        break;
+
+      default:
+        literal = c >= ' ' && c <= '~';
+        break;
+      }
+
+      // A character which may be repeated no times at all is not needed.
+      if (literal && i + 1 < len &&
+          (pat[i + 1] == '*' || pat[i + 1] == '?' || pat[i + 1] == '{' ||
+           pat[i + 1] == '+'))
+        literal = false;
+
+      if (literal && depth == 0) {
+        text += fold(c);
+      } else {
+        if (text.length() > longest.length())
+          longest = text;
+        text = "";
+      }
+    }
+    if (text.length() > longest.length())
+      longest = text;
+    return longest;
+  }
+}
+
+mask_t::mask_t(const string& pat) : expr(), kind(REGEX), folds(false)
 {
   *this = pat;
   TRACE_CTOR(mask_t, "const string&");
@@ -49,9 +211,106 @@ mask_t& mask_t::operator=(const string& pat)
   expr.assign(pat.c_str(), boost::regex::perl | boost::regex::icase);
 #endif
   VERIFY(valid());
+  analyze(pat);
   return *this;
 }
 
+void mask_t::analyze(const string& pat)
+{
+  string text;
+  bool   at_begin = false;
+  bool   at_end   = false;
+
+  folds = false;
+  if (! parse_plain_pattern(pat, text, at_begin, at_end)) {
+    kind    = REGEX;
+    literal = required_text(pat);
+    return;
+  }
+
+  foreach (char c, text)
+    if (c >= 'a' && c <= 'z')
+      folds = true;
+
+  literal = text;
+  if (at_begin)
+    kind = at_end ? EXACT : PREFIX;
+  else
+    kind = at_end ? SUFFIX : SUBSTRING;
+}
+
+bool mask_t::is_plain_text(const string& text)
+{
+  // Non-ASCII text is left to the regex, as are line breaks, at which ^
+  // and $ would also match.
+  foreach (char c, text)
+    if (static_cast<unsigned char>(c) > 0x7f || c == '\n' || c == '\r' ||
+        c == '\f')
+      return false;
+  return true;
+}
+
+bool mask_t::match_literal(const string& text, bool& result) const
+{
+  const char *      data = text.data();
+  std::size_t       len  = text.length();
+  const char *      lit  = literal.data();
+  std::size_t       lit_len = literal.length();
+
+  if (! is_plain_text(text))
+    return false;
+
+  if (lit_len > len) {
+    result = false;
+    return true;
+  }
+
+  switch (kind) {
+  case EXACT:
+    if (lit_len != len) {
+      result = false;
+      break;
+    }
+    // fallthrough...
+  case PREFIX:
+    result = (folds ? equal_folded(data, lit, lit_len) :
+              std::memcmp(data, lit, lit_len) == 0);
+    break;
+
+  case SUFFIX:
+    data += len - lit_len;
+    result = (folds ? equal_folded(data, lit, lit_len) :
+              std::memcmp(data, lit, lit_len) == 0);
+    break;
+
+  case SUBSTRING: {
+    result = true;
+    if (lit_len == 0)
+      break;
+
+    const char * last = data + (len - lit_len);
+    if (! folds) {
+      for (const char * p = data;
+           (p = static_cast<const char *>
+            (std::memchr(p, *lit, static_cast<std::size_t>(last - p + 1))));
+           p++)
+        if (std::memcmp(p + 1, lit + 1, lit_len - 1) == 0)
+          return true;
+    } else {
+      for (const char * p = data; p <= last; p++)
+        if (fold(*p) == *lit && equal_folded(p + 1, lit + 1, lit_len - 1))
+          return true;
+    }
+    result = false;
+    break;
+  }
+
+  case REGEX:
+    return false;
+  }
+  return true;
+}
+
 mask_t& mask_t::assign_glob(const string& pat)
 {
   string re_pat = "";
@@ -86,4 +345,186 @@ mask_t& mask_t::assign_glob(const string& pat)
   return (*this = re_pat);
 }
 
+struct mask_set_t::automaton_t
+{
+  static const std::size_t none = static_cast<std::size_t>(-1);
+
+  struct state_t {
+    std::vector<std::pair<char, std::size_t> > next; // sorted by character
+    std::size_t fail;           // state of the longest proper suffix
+    std::size_t output;         // text ending in this state, or none
+    std::size_t dict;           // next state along fail with an output
+
+    state_t() : fail(0), output(none), dict(none) {}
+  };
+
+  // A mask needing the text of an output.
+  struct user_t {
+    std::size_t index;
+    bool        at_begin;       // the text must begin the string
+    bool        at_end;         // the text must end the string
+    bool        verify;         // the mask must still be matched itself
+  };
+
+  std::vector<state_t>               states;
+  std::vector<std::size_t>           lengths; // of each output's text
+  std::vector<std::vector<user_t> >  users;   // of each output, in order
+  std::vector<std::size_t>           always;  // masks needing no text
+  std::size_t                        size;    // masks covered
+
+  explicit automaton_t(const std::vector<mask_t>& masks);
+
+  std::size_t step(std::size_t state, const char c) const {
+    typedef std::pair<char, std::size_t> edge_t;
+    const std::vector<edge_t>& next(states[state].next);
+    std::vector<edge_t>::const_iterator i =
+      std::lower_bound(next.begin(), next.end(), edge_t(c, 0));
+    return i != next.end() && i->first == c ? i->second : none;
+  }
+};
+
+mask_set_t::automaton_t::automaton_t(const std::vector<mask_t>& masks)
+  : size(masks.size())
+{
+  states.push_back(state_t());
+
+  for (std::size_t index = 0; index < masks.size(); index++) {
+    const mask_t& mask(masks[index]);
+    if (mask.literal.empty()) {
+      always.push_back(index);
+      continue;
+    }
+
+    std::size_t state = 0;
+    foreach (char c, mask.literal) {
+      std::size_t next = step(state, c);
+      if (next == none) {
+        next = states.size();
+        states.push_back(state_t());
+        std::vector<std::pair<char, std::size_t> >& edges(states[state].next);
+        edges.insert(std::lower_bound(edges.begin(), edges.end(),
+                                      std::make_pair(c, std::size_t(0))),
+                     std::make_pair(c, next));
+      }
+      state = next;
+    }
+
+    if (states[state].output == none) {
+      states[state].output = users.size();
+      users.push_back(std::vector<user_t>());
+      lengths.push_back(mask.literal.length());
+    }
+
+    user_t user;
+    user.index    = index;
+    user.at_begin = mask.kind == mask_t::PREFIX || mask.kind == mask_t::EXACT;
+    user.at_end   = mask.kind == mask_t::SUFFIX || mask.kind == mask_t::EXACT;
+    user.verify   = mask.kind == mask_t::REGEX;
+    users[states[state].output].push_back(user);
+  }
+
+  // Link every state to the longest proper suffix of its text which is
+  // also a state, visiting the states breadth first.
+  std::deque<std::size_t> queue;
+  typedef std::pair<char, std::size_t> edge_t;
+  foreach (const edge_t& edge, states[0].next)
+    queue.push_back(edge.second);
+
+  while (! queue.empty()) {
+    std::size_t state = queue.front();
+    queue.pop_front();
+
+    foreach (const edge_t& edge, states[state].next) {
+      std::size_t fail = states[state].fail;
+      std::size_t next;
+      while ((next = step(fail, edge.first)) == none && fail != 0)
+        fail = states[fail].fail;
+
+      state_t& child(states[edge.second]);
+      child.fail = next != none ? next : 0;
+      child.dict = (states[child.fail].output != none ?
+                    child.fail : states[child.fail].dict);
+      queue.push_back(edge.second);
+    }
+  }
+}
+
+std::size_t mask_set_t::match(const string& text) const
+{
+  if (masks.empty() || ! mask_t::is_plain_text(text)) {
+    for (std::size_t i = 0; i < masks.size(); i++)
+      if (masks[i].match(text))
+        return i;
+    return masks.size();
+  }
+
+  if (automaton && automaton->size < masks.size()) {
+    unbuilt_cost += masks.size() - automaton->size;
+    if (unbuilt_cost >= masks.size())
+      automaton.reset();
+  }
+  if (! automaton) {
+    automaton.reset(new automaton_t(masks));
+    unbuilt_cost = 0;
+  }
+
+  const automaton_t&       a(*automaton);
+  std::size_t              best  = a.size;
+  std::size_t              state = 0;
+  std::size_t              len   = text.length();
+  std::vector<std::size_t> candidates;
+
+  for (std::size_t i = 0; i < len; i++) {
+    const char  c = fold(text[i]);
+    std::size_t next;
+    while ((next = a.step(state, c)) == automaton_t::none && state != 0)
+      state = a.states[state].fail;
+    state = next != automaton_t::none ? next : 0;
+
+    for (std::size_t found = (a.states[state].output != automaton_t::none ?
+                              state : a.states[state].dict);
+         found != automaton_t::none;
+         found = a.states[found].dict) {
+      std::size_t output = a.states[found].output;
+      bool        begins = i + 1 == a.lengths[output];
+      bool        ends   = i + 1 == len;
+
+      foreach (const automaton_t::user_t& user, a.users[output]) {
+        if (user.index >= best)
+          break;
+        if ((user.at_begin && ! begins) || (user.at_end && ! ends))
+          continue;
+        if (! user.verify) {
+          best = user.index;
+          break;
+        }
+        candidates.push_back(user.index);
+      }
+    }
+  }
+
+  foreach (std::size_t index, a.always) {
+    if (index >= best)
+      break;
+    candidates.push_back(index);
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+  foreach (std::size_t index, candidates) {
+    if (index >= best)
+      break;
+    if (masks[index].match(text))
+      return index;
+  }
+  if (best < a.size)
+    return best;
+
+  for (std::size_t i = a.size; i < masks.size(); i++)
+    if (masks[i].match(text))
+      return i;
+  return masks.size();
+}
+
 } // namespace ledger
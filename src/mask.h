@@ -60,18 +60,50 @@ public:
   boost::regex expr;
 #endif
 
+private:
+  // Patterns which are plain text, optionally anchored with ^ or $, are
+  // matched by comparing characters rather than by running the regex.
+  enum literal_kind_t {
+    REGEX,                      // a real regex
+    SUBSTRING,                  // text
+    PREFIX,                     // ^text
+    SUFFIX,                     // text$
+    EXACT                       // ^text$
+  };
+
+  literal_kind_t kind;
+  string         literal;       // the text, in lower case; for a regex,
+                                // the text any match must contain
+  bool           folds;         // true if the text contains any letters
+
+  void analyze(const string& pattern);
+  bool match_literal(const string& text, bool& result) const;
+
+  static bool is_plain_text(const string& text);
+
+  friend class mask_set_t;
+
+public:
   explicit mask_t(const string& pattern);
 
-  mask_t() : expr() {
+  mask_t() : expr(), kind(REGEX), folds(false) {
     TRACE_CTOR(mask_t, "");
   }
-  mask_t(const mask_t& m) : expr(m.expr) {
+  mask_t(const mask_t& m)
+    : expr(m.expr), kind(m.kind), literal(m.literal), folds(m.folds) {
     TRACE_CTOR(mask_t, "copy");
   }
   ~mask_t() throw() {
     TRACE_DTOR(mask_t);
   }
 
+  mask_t& operator=(const mask_t& m) {
+    expr    = m.expr;
+    kind    = m.kind;
+    literal = m.literal;
+    folds   = m.folds;
+    return *this;
+  }
   mask_t& operator=(const string& other);
   mask_t& assign_glob(const string& other);
 
@@ -83,17 +115,17 @@ public:
   }
 
   bool match(const string& text) const {
+    bool result;
+    if (kind == REGEX || ! match_literal(text, result))
 #if HAVE_BOOST_REGEX_UNICODE
-    DEBUG("mask.match",
-          "Matching: \"" << text << "\" =~ /" << str() << "/ = "
-          << (boost::u32regex_search(text, expr) ? "true" : "false"));
-    return boost::u32regex_search(text, expr);
+      result = boost::u32regex_search(text, expr);
 #else
+      result = boost::regex_search(text, expr);
+#endif
     DEBUG("mask.match",
           "Matching: \"" << text << "\" =~ /" << str() << "/ = "
-          << (boost::regex_search(text, expr) ? "true" : "false"));
-    return boost::regex_search(text, expr);
-#endif
+          << (result ? "true" : "false"));
+    return result;
   }
 
   bool empty() const {
@@ -126,6 +158,108 @@ public:
   }
 };
 
+/**
+ * @brief A list of masks tried against a text all at once.
+ *
+ * Matching yields the first mask in the list which matches.  The text
+ * that each mask requires is searched for in a single pass, using an
+ * Aho-Corasick automaton, so that only the masks whose text occurs need
+ * to be matched on their own.
+ */
+class mask_set_t
+{
+  struct automaton_t;
+
+  std::vector<mask_t>                 masks;
+
+  // The automaton covers the masks present when it was built.  Masks
+  // added since are matched one by one, until doing so has cost about as
+  // much as building it again.
+  mutable shared_ptr<automaton_t>     automaton;
+  mutable std::size_t                 unbuilt_cost;
+
+public:
+  mask_set_t() : unbuilt_cost(0) {
+    TRACE_CTOR(mask_set_t, "");
+  }
+  mask_set_t(const mask_set_t& other)
+    : masks(other.masks), automaton(other.automaton),
+      unbuilt_cost(other.unbuilt_cost) {
+    TRACE_CTOR(mask_set_t, "copy");
+  }
+  ~mask_set_t() {
+    TRACE_DTOR(mask_set_t);
+  }
+
+  void push_back(const mask_t& mask) {
+    masks.push_back(mask);
+  }
+
+  std::size_t size() const {
+    return masks.size();
+  }
+  bool empty() const {
+    return masks.empty();
+  }
+
+  /**
+   * Returns the position of the first mask matching text, or size() if
+   * none of them does.
+   */
+  std::size_t match(const string& text) const;
+};
+
+/**
+ * @brief A list of masks, each paired with a value.
+ *
+ * Such as the payee aliases of a journal, where the value of the first
+ * mask that matches a name is wanted.
+ */
+template <typename T>
+class mask_table_t
+{
+public:
+  typedef std::pair<mask_t, T>                     value_type;
+  typedef std::deque<value_type>                   entries_t;
+  typedef typename entries_t::iterator             iterator;
+  typedef typename entries_t::const_iterator       const_iterator;
+
+private:
+  entries_t  entries;
+  mask_set_t masks;
+
+public:
+  void push_back(const value_type& entry) {
+    entries.push_back(entry);
+    masks.push_back(entry.first);
+  }
+
+  value_type * find(const string& text) {
+    std::size_t i = masks.match(text);
+    return i < entries.size() ? &entries[i] : NULL;
+  }
+
+  iterator begin() {
+    return entries.begin();
+  }
+  iterator end() {
+    return entries.end();
+  }
+  const_iterator begin() const {
+    return entries.begin();
+  }
+  const_iterator end() const {
+    return entries.end();
+  }
+
+  std::size_t size() const {
+    return entries.size();
+  }
+  bool empty() const {
+    return entries.empty();
+  }
+};
+
 inline std::ostream& operator<<(std::ostream& out, const mask_t& mask) {
   out << mask.str();
   return out;
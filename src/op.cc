@@ -38,6 +38,11 @@
 
 namespace ledger {
 
+#if !defined(THREADSAFE)
+std::size_t expr_t::op_t::calc_serial      = 0;
+std::size_t expr_t::op_t::last_calc_serial = 0;
+#endif
+
 void intrusive_ptr_add_ref(const expr_t::op_t * op)
 {
   op->acquire();
@@ -86,6 +91,101 @@ namespace {
   }
 }
 
+namespace {
+  bool is_pure_operator(expr_t::op_t::kind_t kind)
+  {
+    switch (kind) {
+    case expr_t::op_t::O_NOT:
+    case expr_t::op_t::O_NEG:
+    case expr_t::op_t::O_EQ:
+    case expr_t::op_t::O_LT:
+    case expr_t::op_t::O_LTE:
+    case expr_t::op_t::O_GT:
+    case expr_t::op_t::O_GTE:
+    case expr_t::op_t::O_AND:
+    case expr_t::op_t::O_OR:
+    case expr_t::op_t::O_ADD:
+    case expr_t::op_t::O_SUB:
+    case expr_t::op_t::O_MUL:
+    case expr_t::op_t::O_DIV:
+    case expr_t::op_t::O_QUERY:
+    case expr_t::op_t::O_COLON:
+    case expr_t::op_t::O_MATCH:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  bool constant_truth(const expr_t::ptr_op_t& op, bool& truth)
+  {
+    if (! op->is_value())
+      return false;
+    try {
+      truth = op->as_value();
+      return true;
+    }
+    catch (const std::exception&) {
+      error_context();          // leave the error for calc to report
+      return false;
+    }
+  }
+
+  // Reduce operators whose operands are known at compile time.  Logical
+  // operators and O_QUERY only need their first operand to be constant;
+  // constant steps of an O_SEQ, other than the last, are dropped.
+  expr_t::ptr_op_t fold_constants(expr_t::ptr_op_t op, scope_t& scope,
+                                  const int depth)
+  {
+    bool truth;
+
+    switch (op->kind) {
+    case expr_t::op_t::O_QUERY:
+      if (op->right()->kind == expr_t::op_t::O_COLON &&
+          constant_truth(op->left(), truth))
+        return truth ? op->right()->left() : op->right()->right();
+      return op;
+
+    case expr_t::op_t::O_AND:
+      if (constant_truth(op->left(), truth))
+        return truth ? op->right() : expr_t::op_t::wrap_value(false);
+      break;
+
+    case expr_t::op_t::O_OR:
+      if (constant_truth(op->left(), truth))
+        return truth ? op->left() : op->right();
+      break;
+
+    case expr_t::op_t::O_SEQ:
+      if (op->left()->is_value() && op->has_right())
+        return op->right();
+      return op;
+
+    case expr_t::op_t::O_COLON:
+      return op;
+
+    default:
+      if (! is_pure_operator(op->kind))
+        return op;
+      break;
+    }
+
+    if (op->left()->is_value() &&
+        (op->kind < expr_t::op_t::UNARY_OPERATORS ||
+         (op->has_right() && op->right()->is_value()))) {
+      try {
+        return expr_t::op_t::wrap_value(op->calc(scope, NULL, depth + 1));
+      }
+      catch (const std::exception&) {
+        // Errors such as division by zero are reported when the
+        // expression is evaluated, as they would be without folding.
+        error_context();
+      }
+    }
+    return op;
+  }
+}
+
 expr_t::ptr_op_t expr_t::op_t::compile(scope_t& scope, const int depth,
                                        scope_t * param_scope)
 {
@@ -211,12 +311,17 @@ expr_t::ptr_op_t expr_t::op_t::compile(scope_t& scope, const int depth,
     } else {
       ptr_op_t intermediate(copy(lhs, rhs));
 
-      // Reduce constants immediately if possible
-      if ((! lhs || lhs->is_value()) && (! rhs || rhs->is_value()))
+      // Reduce constants immediately if possible; an O_COLON is only
+      // ever evaluated through its O_QUERY
+      if (kind != O_COLON &&
+          (! lhs || lhs->is_value()) && (! rhs || rhs->is_value()))
         result = wrap_value(intermediate->calc(*scope_ptr, NULL, depth + 1));
       else
         result = intermediate;
     }
+
+    if (! result->is_value())
+      result = fold_constants(result, *scope_ptr, depth);
   }
 
 #if DEBUG_ON
@@ -236,8 +341,25 @@ namespace {
     expr_t::ptr_op_t def = op->left();
 
     // If no definition was pre-compiled for this identifier, look it up
-    // in the current scope.
+    // in the current scope.  When the first scope asked is a posting,
+    // transaction or account, the answer depends only on its type and
+    // is kept in the identifier's slot for the next evaluation.
     if (! def || def->kind == expr_t::op_t::PLUG) {
+      scope_t * first = scope.lookup_scope();
+      if (first->lookup_by_type()) {
+        const std::type_info * type = &typeid(*first);
+        if (op->slot_type == type)
+          return op->slot_def;
+
+        DEBUG("scope.symbols",
+              "Resolving IDENT '" << op->as_ident() << "' for " << type->name());
+        if ((def = first->lookup(symbol_t::FUNCTION, op->as_ident()))) {
+          op->slot_type = type;
+          op->slot_def  = def;
+          return def;
+        }
+      }
+
       DEBUG("scope.symbols", "Looking for IDENT '" << op->as_ident() << "'");
       def = scope.lookup(symbol_t::FUNCTION, op->as_ident());
     }
@@ -251,6 +373,17 @@ value_t expr_t::op_t::calc(scope_t& scope, ptr_op_t * locus, const int depth)
 {
   try {
 
+#if !defined(THREADSAFE)
+  scope_t * memo_item = NULL;
+  if (memo && calc_serial) {
+    memo_item = scope.lookup_scope();
+    if (! memo_item->lookup_by_type())
+      memo_item = NULL;
+    else if (memo->serial == calc_serial && memo->item == memo_item)
+      return memo->value;
+  }
+#endif
+
   value_t result;
 
 #if DEBUG_ON
@@ -425,6 +558,14 @@ value_t expr_t::op_t::calc(scope_t& scope, ptr_op_t * locus, const int depth)
   }
 #endif
 
+#if !defined(THREADSAFE)
+  if (memo_item) {
+    memo->serial = calc_serial;
+    memo->item   = memo_item;
+    memo->value  = result;
+  }
+#endif
+
   return result;
 
   }
@@ -613,6 +754,87 @@ value_t expr_t::op_t::calc_seq(scope_t& scope, ptr_op_t * locus,
   return result;
 }
 
+namespace {
+  typedef std::map<string, expr_t::ptr_op_t> common_map;
+
+  // Returns a key describing the value computed by `op', or an empty
+  // string if that value may depend on more than the item the expression
+  // is evaluated for.  Subexpressions with the same key are replaced by
+  // the first one seen, which is then marked to remember its result.
+  string share_subexpressions(expr_t::ptr_op_t& op, common_map& seen)
+  {
+    typedef value_t (*accessor_t)(call_scope_t&);
+
+    std::ostringstream key;
+
+    switch (op->kind) {
+    case expr_t::op_t::VALUE:
+      key << 'V';
+      op->as_value().dump(key);
+      return key.str();
+
+    case expr_t::op_t::FUNCTION:
+      // Only plain functions, such as the item accessors, can be told
+      // apart; bound member functions all have the same type.
+      if (const accessor_t * func = op->as_function().target<accessor_t>()) {
+        key << 'F' << reinterpret_cast<std::size_t>(*func);
+        return key.str();
+      }
+      return string();
+
+    case expr_t::op_t::IDENT:
+      // Within one expression a name always resolves the same way, so an
+      // identifier bound to a function is keyed by its name.
+      if (op->left() && op->left()->is_function()) {
+        key << 'I' << op->as_ident();
+        return key.str();
+      }
+      return string();
+
+    default:
+      if (op->kind < expr_t::op_t::TERMINALS || ! op->left())
+        return string();
+      break;
+    }
+
+    expr_t::ptr_op_t lhs(op->left());
+    string           lkey(share_subexpressions(lhs, seen));
+    expr_t::ptr_op_t rhs;
+    string           rkey;
+    if (op->kind > expr_t::op_t::UNARY_OPERATORS && op->has_right()) {
+      rhs  = op->right();
+      rkey = share_subexpressions(rhs, seen);
+    }
+
+    if (lhs != op->left() || (rhs && rhs != op->right()))
+      op = expr_t::op_t::new_node(op->kind, lhs, rhs);
+
+    if (! is_pure_operator(op->kind) || lkey.empty() ||
+        (rhs && rkey.empty()))
+      return string();
+
+    key << '(' << int(op->kind) << ' ' << lkey << ' ' << rkey << ')';
+
+    common_map::iterator i = seen.find(key.str());
+    if (i == seen.end()) {
+      seen.insert(common_map::value_type(key.str(), op));
+    } else {
+      op = (*i).second;
+      if (! op->memo)
+        op->memo.reset(new expr_t::op_t::memo_t);
+    }
+    return key.str();
+  }
+}
+
+expr_t::ptr_op_t expr_t::op_t::share_common()
+{
+  common_map       seen;
+  expr_t::ptr_op_t op(this);
+  share_subexpressions(op, seen);
+  return op;
+}
+
 namespace {
   bool print_cons(std::ostream& out, const expr_t::const_ptr_op_t op,
                   const expr_t::op_t::context_t& context)
@@ -874,15 +1096,8 @@ bool expr_t::op_t::print(std::ostream& out, const context_t& context) const
   return found;
 }
 
-void expr_t::op_t::dump(std::ostream& out, const int depth) const
+void expr_t::op_t::dump_kind(std::ostream& out) const
 {
-  out.setf(std::ios::left);
-  out.width((sizeof(void *) * 2) + 2);
-  out << this;
-
-  for (int i = 0; i < depth; i++)
-    out << " ";
-
   switch (kind) {
   case PLUG:
     out << "PLUG";
@@ -943,6 +1158,18 @@ void expr_t::op_t::dump(std::ostream& out, const int depth) const
     assert(false);
     break;
   }
+}
+
+void expr_t::op_t::dump(std::ostream& out, const int depth) const
+{
+  out.setf(std::ios::left);
+  out.width((sizeof(void *) * 2) + 2);
+  out << this;
+
+  for (int i = 0; i < depth; i++)
+    out << " ";
+
+  dump_kind(out);
 
   out << " (" << refc << ')' << std::endl;
 
@@ -960,6 +1187,25 @@ void expr_t::op_t::dump(std::ostream& out, const int depth) const
   }
 }
 
+void expr_t::op_t::explain(std::ostream& out, const int depth) const
+{
+  for (int i = 0; i < depth; i++)
+    out << "  ";
+
+  dump_kind(out);
+  if (memo)
+    out << _(" (shared)");
+  out << std::endl;
+
+  if (kind > TERMINALS || is_scope() || is_ident()) {
+    if (left()) {
+      left()->explain(out, depth + 1);
+      if (kind > UNARY_OPERATORS && has_right())
+        right()->explain(out, depth + 1);
+    }
+  }
+}
+
 string op_context(const expr_t::ptr_op_t op,
                   const expr_t::ptr_op_t locus)
 {
@@ -123,10 +123,39 @@ public:
 
   kind_t kind;
 
-  explicit op_t() : refc(0), kind(UNKNOWN) {
+  // An IDENT which compile could not resolve remembers the type of the
+  // item scope it was last found in, and what it resolved to there, so
+  // that later evaluations against the same kind of item need not look
+  // it up by name again.
+  const std::type_info * slot_type;
+  ptr_op_t               slot_def;
+
+  // A subexpression which share_common found more than once in the same
+  // expression keeps its last result, together with the item and the
+  // evaluation it was computed for, so that later occurrences within
+  // that evaluation need not compute it again.
+  struct memo_t
+  {
+    std::size_t serial;
+    scope_t *   item;
+    value_t     value;
+
+    memo_t() : serial(0), item(NULL) {}
+  };
+  unique_ptr<memo_t> memo;
+
+#if !defined(THREADSAFE)
+  // Each top-level evaluation of an expression gets a new serial number;
+  // zero means that no evaluation is in progress.
+  static std::size_t calc_serial;
+  static std::size_t last_calc_serial;
+#endif
+
+  explicit op_t() : refc(0), kind(UNKNOWN), slot_type(NULL) {
     TRACE_CTOR(op_t, "");
   }
-  explicit op_t(const kind_t _kind) : refc(0), kind(_kind) {
+  explicit op_t(const kind_t _kind)
+    : refc(0), kind(_kind), slot_type(NULL) {
     TRACE_CTOR(op_t, "const kind_t");
   }
   ~op_t() {
@@ -277,6 +306,7 @@ public:
 
   ptr_op_t compile(scope_t& scope, const int depth = 0,
                    scope_t * param_scope = NULL);
+  ptr_op_t share_common();
   value_t  calc(scope_t& scope, ptr_op_t * locus = NULL,
                 const int depth = 0);
 
@@ -305,12 +335,15 @@ public:
 
   bool print(std::ostream& out, const context_t& context = context_t()) const;
   void dump(std::ostream& out, const int depth = 0) const;
+  void explain(std::ostream& out, const int depth = 0) const;
 
   static ptr_op_t wrap_value(const value_t& val);
   static ptr_op_t wrap_functor(expr_t::func_t fobj);
   static ptr_op_t wrap_scope(shared_ptr<scope_t> sobj);
 
 private:
+  void dump_kind(std::ostream& out) const;
+
   value_t calc_call(scope_t& scope, ptr_op_t * locus, const int depth);
   value_t calc_cons(scope_t& scope, ptr_op_t * locus, const int depth);
   value_t calc_seq(scope_t& scope, ptr_op_t * locus, const int depth);
@@ -257,6 +257,19 @@ inline bool is_eq(const char * p, const char * n) {
        *(p + 1) == '_' && ! *(p + 2)))                                  \
     return ((name ## handler).parent = this, &(name ## handler))
 
+// Case labels for a `switch (hash_name(p))' over long option names.
+#define OPT_CASE(name)                                                  \
+  case hash_name(#name):                                                \
+    if (is_eq(p, #name))                                                \
+      return ((name ## handler).parent = this, &(name ## handler));     \
+    break
+
+#define OPT_ALT_CASE(name, alt)                                         \
+  case hash_name(#alt):                                                 \
+    if (is_eq(p, #alt))                                                 \
+      return ((name ## handler).parent = this, &(name ## handler));     \
+    break
+
 #define HANDLER(name) name ## handler
 #define HANDLED(name) HANDLER(name)
 
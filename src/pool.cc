@@ -219,6 +219,47 @@ commodity_pool_t::create(commodity_t&        comm,
   return commodity.get();
 }
 
+void commodity_pool_t::adopt(commodity_pool_t& other)
+{
+  for (commodities_map::iterator i = other.commodities.begin();
+       i != other.commodities.end(); ) {
+    commodity_t& comm(*(*i).second);
+    if (&comm == other.null_commodity) {
+      ++i;
+      continue;
+    }
+
+    DEBUG("pool.commodities", "Adopting commodity " << (*i).first);
+
+    comm.parent_ = this;
+    comm.set_graph_index();
+
+#if DEBUG_ON
+    std::pair<commodities_map::iterator, bool> result =
+#endif
+      commodities.insert(*i);
+#if DEBUG_ON
+    assert(result.second);
+#endif
+
+    commodity_price_history.add_commodity(comm);
+    other.commodities.erase(i++);
+  }
+
+  foreach (annotated_commodities_map::value_type& pair,
+           other.annotated_commodities) {
+    static_cast<commodity_t&>(*pair.second).parent_ = this;
+#if DEBUG_ON
+    std::pair<annotated_commodities_map::iterator, bool> result =
+#endif
+      annotated_commodities.insert(pair);
+#if DEBUG_ON
+    assert(result.second);
+#endif
+  }
+  other.annotated_commodities.clear();
+}
+
 void commodity_pool_t::exchange(commodity_t&      commodity,
                                 const amount_t&   per_unit_cost,
                                 const datetime_t& moment)
@@ -109,6 +109,11 @@ public:
   annotated_commodity_t * create(commodity_t& comm,
                                  const annotation_t& details);
 
+  // Take over every commodity created in `other', which must not already
+  // be known here.  Its null commodity stays behind.
+
+  void adopt(commodity_pool_t& other);
+
   // Exchange one commodity for another, while recording the factored price.
 
   void exchange(commodity_t&      commodity,
@@ -414,130 +414,173 @@ expr_t::ptr_op_t post_t::lookup(const symbol_t::kind_t kind,
   if (kind != symbol_t::FUNCTION)
     return item_t::lookup(kind, name);
 
-  switch (name[0]) {
-  case 'a':
+  switch (hash_name(name.c_str())) {
+  case hash_name("a"):
+  case hash_name("amount"):
     if (name[1] == '\0' || name == "amount")
       return WRAP_FUNCTOR(get_wrapper<&get_amount>);
-    else if (name == "account")
+    break;
+  case hash_name("account"):
+    if (name == "account")
       return WRAP_FUNCTOR(get_account);
-    else if (name == "account_base")
+    break;
+  case hash_name("account_base"):
+    if (name == "account_base")
       return WRAP_FUNCTOR(get_wrapper<&get_account_base>);
-    else if (name == "account_id")
+    break;
+  case hash_name("account_id"):
+    if (name == "account_id")
       return WRAP_FUNCTOR(get_wrapper<&get_account_id>);
-    else if (name == "any")
+    break;
+  case hash_name("any"):
+    if (name == "any")
       return WRAP_FUNCTOR(&fn_any);
-    else if (name == "all")
+    break;
+  case hash_name("all"):
+    if (name == "all")
       return WRAP_FUNCTOR(&fn_all);
     break;
 
-  case 'b':
+  case hash_name("b"):
     if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_cost>);
     break;
 
-  case 'c':
+  case hash_name("code"):
     if (name == "code")
       return WRAP_FUNCTOR(get_wrapper<&get_code>);
-    else if (name == "cost")
+    break;
+  case hash_name("cost"):
+    if (name == "cost")
       return WRAP_FUNCTOR(get_wrapper<&get_cost>);
-    else if (name == "cost_calculated")
+    break;
+  case hash_name("cost_calculated"):
+    if (name == "cost_calculated")
       return WRAP_FUNCTOR(get_wrapper<&get_is_cost_calculated>);
-    else if (name == "count")
+    break;
+  case hash_name("count"):
+    if (name == "count")
       return WRAP_FUNCTOR(get_wrapper<&get_count>);
-    else if (name == "calculated")
+    break;
+  case hash_name("calculated"):
+    if (name == "calculated")
       return WRAP_FUNCTOR(get_wrapper<&get_is_calculated>);
-    else if (name == "commodity")
+    break;
+  case hash_name("commodity"):
+    if (name == "commodity")
       return WRAP_FUNCTOR(&get_commodity);
-    else if (name == "checkin")
+    break;
+  case hash_name("checkin"):
+    if (name == "checkin")
       return WRAP_FUNCTOR(get_wrapper<&get_checkin>);
-    else if (name == "checkout")
+    break;
+  case hash_name("checkout"):
+    if (name == "checkout")
       return WRAP_FUNCTOR(get_wrapper<&get_checkout>);
     break;
 
-  case 'd':
+  case hash_name("display_account"):
     if (name == "display_account")
       return WRAP_FUNCTOR(get_display_account);
-    else if (name == "depth")
+    break;
+  case hash_name("depth"):
+    if (name == "depth")
       return WRAP_FUNCTOR(get_wrapper<&get_account_depth>);
-    else if (name == "datetime")
+    break;
+  case hash_name("datetime"):
+    if (name == "datetime")
       return WRAP_FUNCTOR(get_wrapper<&get_datetime>);
     break;
 
-  case 'h':
+  case hash_name("has_cost"):
     if (name == "has_cost")
       return WRAP_FUNCTOR(get_wrapper<&get_has_cost>);
     break;
 
-  case 'i':
+  case hash_name("index"):
     if (name == "index")
       return WRAP_FUNCTOR(get_wrapper<&get_count>);
     break;
 
-  case 'm':
+  case hash_name("magnitude"):
     if (name == "magnitude")
       return WRAP_FUNCTOR(get_wrapper<&get_magnitude>);
     break;
 
-  case 'n':
+  case hash_name("note"):
     if (name == "note")
       return WRAP_FUNCTOR(get_wrapper<&get_note>);
-    else if (name[1] == '\0')
+    break;
+  case hash_name("n"):
+    if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_count>);
     break;
 
-  case 'p':
+  case hash_name("post"):
     if (name == "post")
       return WRAP_FUNCTOR(get_wrapper<&get_this>);
-    else if (name == "payee")
+    break;
+  case hash_name("payee"):
+    if (name == "payee")
       return WRAP_FUNCTOR(get_wrapper<&get_payee>);
-    else if (name == "primary")
+    break;
+  case hash_name("primary"):
+    if (name == "primary")
       return WRAP_FUNCTOR(get_wrapper<&get_commodity_is_primary>);
-    else if (name == "price")
+    break;
+  case hash_name("price"):
+    if (name == "price")
       return WRAP_FUNCTOR(get_wrapper<&get_price>);
-    else if (name == "parent")
+    break;
+  case hash_name("parent"):
+    if (name == "parent")
       return WRAP_FUNCTOR(get_wrapper<&get_xact>);
     break;
 
-  case 'r':
+  case hash_name("real"):
     if (name == "real")
       return WRAP_FUNCTOR(get_wrapper<&get_real>);
     break;
 
-  case 't':
+  case hash_name("total"):
     if (name == "total")
       return WRAP_FUNCTOR(get_wrapper<&get_total>);
     break;
 
-  case 'u':
+  case hash_name("use_direct_amount"):
     if (name == "use_direct_amount")
       return WRAP_FUNCTOR(get_wrapper<&get_use_direct_amount>);
     break;
 
-  case 'v':
+  case hash_name("virtual"):
     if (name == "virtual")
       return WRAP_FUNCTOR(get_wrapper<&get_virtual>);
-    else if (name == "value_date")
+    break;
+  case hash_name("value_date"):
+    if (name == "value_date")
       return WRAP_FUNCTOR(get_wrapper<&get_value_date>);
     break;
 
-  case 'x':
+  case hash_name("xact"):
     if (name == "xact")
       return WRAP_FUNCTOR(get_wrapper<&get_xact>);
-    else if (name == "xact_id")
+    break;
+  case hash_name("xact_id"):
+    if (name == "xact_id")
       return WRAP_FUNCTOR(get_wrapper<&get_xact_id>);
     break;
 
-  case 'N':
+  case hash_name("N"):
     if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_count>);
     break;
 
-  case 'O':
+  case hash_name("O"):
     if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_total>);
     break;
 
-  case 'R':
+  case hash_name("R"):
     if (name[1] == '\0')
       return WRAP_FUNCTOR(get_wrapper<&get_real>);
     break;
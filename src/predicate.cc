@@ -0,0 +1,661 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <system.hh>
+
+#include "predicate.h"
+#include "op.h"
+#include "scope.h"
+#include "post.h"
+#include "xact.h"
+#include "account.h"
+
+namespace ledger {
+
+/**
+ * A node of a compiled predicate.  Leaves compute what the post_t
+ * accessors of the same name would, so that every node yields the value
+ * the corresponding expression node would have calculated.
+ */
+class predicate_t::matcher_t
+{
+public:
+  enum kind_t {
+    CONSTANT,                   // a VALUE node
+    ACCOUNT,                    // account =~ /mask/
+    PAYEE,                      // payee =~ /mask/
+    CODE,                       // code =~ /mask/
+    NOTE,                       // note =~ /mask/
+    TAG,                        // has_tag(/mask/[, /mask/])
+    TAG_NAME,                   // has_tag("name")
+    DATE,                       // date <op> [date]
+    AMOUNT,                     // amount <op> value
+    NOT,
+    AND,
+    OR,
+    EXPR                        // anything else, calculated as an expression
+  };
+
+  kind_t                kind;
+  expr_t::op_t::kind_t  compare;
+  mask_t                mask;
+  optional<mask_t>      value_mask;
+  value_t               operand;
+  expr_t::ptr_op_t      op;
+  unique_ptr<matcher_t> left;
+  unique_ptr<matcher_t> right;
+
+  // True if this node always yields a boolean, so that test() never needs
+  // to produce the value itself.
+  bool                  boolean;
+
+  explicit matcher_t(kind_t _kind)
+    : kind(_kind), compare(expr_t::op_t::LAST), boolean(true) {
+    TRACE_CTOR(predicate_t::matcher_t, "kind_t");
+  }
+  ~matcher_t() {
+    TRACE_DTOR(predicate_t::matcher_t);
+  }
+
+  static unique_ptr<matcher_t> compile(const expr_t::ptr_op_t& op);
+
+  bool    test(post_t& post, scope_t& scope) const;
+  value_t calc(post_t& post, scope_t& scope) const;
+
+  // True if testing this node only reads from the posting, its
+  // transaction and its account.  An amount is copied when it is
+  // compared, which shares its storage; a tag's value is printed before
+  // it is matched, which uses the static buffers of amount.cc; and
+  // expressions keep results in their nodes.
+  bool is_thread_safe() const {
+    switch (kind) {
+    case AMOUNT:
+    case EXPR:
+      return false;
+    case TAG:
+      return ! value_mask;
+    case NOT:
+      return left->is_thread_safe();
+    case AND:
+    case OR:
+      return left->is_thread_safe() && right->is_thread_safe();
+    default:
+      return true;
+    }
+  }
+
+  // True if nothing but constants and leaves of the given kind are
+  // tested.
+  bool tests_only(const kind_t subject) const {
+    if (kind == CONSTANT || kind == subject)
+      return true;
+
+    switch (kind) {
+    case NOT:
+      return left->tests_only(subject);
+    case AND:
+    case OR:
+      return left->tests_only(subject) && right->tests_only(subject);
+    default:
+      return false;
+    }
+  }
+};
+
+namespace {
+  typedef predicate_t::matcher_t matcher_t;
+
+  bool is_ident(const expr_t::ptr_op_t& op, const char * name)
+  {
+    return op->is_ident() && op->as_ident() == name;
+  }
+
+  bool is_mask_value(const expr_t::ptr_op_t& op)
+  {
+    return op->is_value() && op->as_value().is_mask();
+  }
+
+  // The arguments of has_tag(), which must all be constants.  They are
+  // gathered the way op_t::calc_call passes them to the function.
+  unique_ptr<matcher_t> compile_has_tag(const expr_t::ptr_op_t& args)
+  {
+    unique_ptr<matcher_t> node;
+    value_t               values;
+
+    if (args->kind == expr_t::op_t::O_CONS) {
+      for (expr_t::ptr_op_t next = args; next; ) {
+        expr_t::ptr_op_t value_op;
+        if (next->kind == expr_t::op_t::O_CONS) {
+          value_op = next->left();
+          next     = next->has_right() ? next->right() : NULL;
+        } else {
+          value_op = next;
+          next     = NULL;
+        }
+        if (! value_op->is_value())
+          return node;
+        values.push_back(value_op->as_value());
+      }
+    }
+    else if (args->is_value()) {
+      values = args->as_value();
+    }
+    else {
+      return node;
+    }
+
+    if (values.size() == 1 && values[0].is_mask()) {
+      node.reset(new matcher_t(matcher_t::TAG));
+      node->mask = values[0].as_mask();
+    }
+    else if (values.size() == 1 && values[0].is_string()) {
+      node.reset(new matcher_t(matcher_t::TAG_NAME));
+      node->operand = values[0];
+    }
+    else if (values.size() == 2 && values[0].is_mask() &&
+             values[1].is_mask()) {
+      node.reset(new matcher_t(matcher_t::TAG));
+      node->mask       = values[0].as_mask();
+      node->value_mask = values[1].as_mask();
+    }
+    return node;
+  }
+
+  bool is_date_ident(const expr_t::ptr_op_t& op)
+  {
+    return is_ident(op, "date") || is_ident(op, "d");
+  }
+
+  void narrow_to(const expr_t::ptr_op_t& op, optional<date_t>& begin,
+                 optional<date_t>& end)
+  {
+    optional<date_t> after;     // the first date allowed
+    optional<date_t> before;    // the first date after those allowed
+
+    switch (op->kind) {
+    case expr_t::op_t::O_AND:
+      narrow_to(op->left(), begin, end);
+      narrow_to(op->right(), begin, end);
+      return;
+
+    case expr_t::op_t::O_EQ:
+    case expr_t::op_t::O_LT:
+    case expr_t::op_t::O_LTE:
+    case expr_t::op_t::O_GT:
+    case expr_t::op_t::O_GTE: {
+      if (! is_date_ident(op->left()) || ! op->right()->is_value() ||
+          ! op->right()->as_value().is_date())
+        return;
+
+      date_t date = op->right()->as_value().as_date();
+      switch (op->kind) {
+      case expr_t::op_t::O_EQ:
+        after  = date;
+        before = date + gregorian::days(1);
+        break;
+      case expr_t::op_t::O_LT:
+        before = date;
+        break;
+      case expr_t::op_t::O_LTE:
+        before = date + gregorian::days(1);
+        break;
+      case expr_t::op_t::O_GT:
+        after = date + gregorian::days(1);
+        break;
+      default:
+        after = date;
+        break;
+      }
+      break;
+    }
+
+    default:
+      return;
+    }
+
+    if (after && (! begin || *after > *begin))
+      begin = after;
+    if (before && (! end || *before < *end))
+      end = before;
+  }
+
+  unique_ptr<matcher_t> compile_term(const expr_t::ptr_op_t& op)
+  {
+    unique_ptr<matcher_t> node;
+
+    switch (op->kind) {
+    case expr_t::op_t::VALUE:
+      node.reset(new matcher_t(matcher_t::CONSTANT));
+      node->operand = op->as_value();
+      node->boolean = node->operand.is_boolean();
+      break;
+
+    case expr_t::op_t::O_MATCH:
+      if (! is_mask_value(op->right()))
+        break;
+      if (is_ident(op->left(), "account"))
+        node.reset(new matcher_t(matcher_t::ACCOUNT));
+      else if (is_ident(op->left(), "payee"))
+        node.reset(new matcher_t(matcher_t::PAYEE));
+      else if (is_ident(op->left(), "code"))
+        node.reset(new matcher_t(matcher_t::CODE));
+      else if (is_ident(op->left(), "note"))
+        node.reset(new matcher_t(matcher_t::NOTE));
+      if (node)
+        node->mask = op->right()->as_value().as_mask();
+      break;
+
+    case expr_t::op_t::O_CALL:
+      if ((is_ident(op->left(), "has_tag") ||
+           is_ident(op->left(), "has_meta")) && op->has_right())
+        node = compile_has_tag(op->right());
+      break;
+
+    case expr_t::op_t::O_EQ:
+    case expr_t::op_t::O_LT:
+    case expr_t::op_t::O_LTE:
+    case expr_t::op_t::O_GT:
+    case expr_t::op_t::O_GTE:
+      if (! op->right()->is_value())
+        break;
+      if (is_date_ident(op->left()) && op->right()->as_value().is_date())
+        node.reset(new matcher_t(matcher_t::DATE));
+      else if (is_ident(op->left(), "amount") || is_ident(op->left(), "a"))
+        node.reset(new matcher_t(matcher_t::AMOUNT));
+      if (node) {
+        node->compare = op->kind;
+        node->operand = op->right()->as_value();
+      }
+      break;
+
+    case expr_t::op_t::O_NOT:
+      node.reset(new matcher_t(matcher_t::NOT));
+      node->left = matcher_t::compile(op->left());
+      break;
+
+    case expr_t::op_t::O_AND:
+    case expr_t::op_t::O_OR:
+      node.reset(new matcher_t(op->kind == expr_t::op_t::O_AND ?
+                               matcher_t::AND : matcher_t::OR));
+      node->left  = matcher_t::compile(op->left());
+      node->right = matcher_t::compile(op->right());
+      node->boolean = node->left->boolean && node->right->boolean;
+      break;
+
+    default:
+      break;
+    }
+    return node;
+  }
+
+  template <typename T>
+  bool compare_values(expr_t::op_t::kind_t compare,
+                      const T& left, const T& right)
+  {
+    switch (compare) {
+    case expr_t::op_t::O_EQ:  return left == right;
+    case expr_t::op_t::O_LT:  return left < right;
+    case expr_t::op_t::O_LTE: return left <= right;
+    case expr_t::op_t::O_GT:  return left > right;
+    case expr_t::op_t::O_GTE: return left >= right;
+    default:
+      assert(false);
+      return false;
+    }
+  }
+
+  bool match_optional(const mask_t& mask, const optional<string>& str)
+  {
+    return mask.match(str ? *str : empty_string);
+  }
+
+  // The terms joined by "and" at the top of the predicate which look at
+  // nothing but the account.
+  void find_account_terms(const matcher_t& node,
+                          std::vector<const matcher_t *>& terms)
+  {
+    if (node.kind == matcher_t::AND) {
+      find_account_terms(*node.left, terms);
+      find_account_terms(*node.right, terms);
+    }
+    else if (node.kind != matcher_t::CONSTANT &&
+             node.tests_only(matcher_t::ACCOUNT)) {
+      terms.push_back(&node);
+    }
+  }
+
+  bool test_account(const matcher_t& node, const string& fullname)
+  {
+    switch (node.kind) {
+    case matcher_t::CONSTANT:
+      return node.operand;
+    case matcher_t::ACCOUNT:
+      return node.mask.match(fullname);
+    case matcher_t::NOT:
+      return ! test_account(*node.left, fullname);
+    case matcher_t::AND:
+      return (test_account(*node.left, fullname) &&
+              test_account(*node.right, fullname));
+    case matcher_t::OR:
+      return (test_account(*node.left, fullname) ||
+              test_account(*node.right, fullname));
+    default:
+      assert(false);
+      return true;
+    }
+  }
+
+  // True if the node is true only of postings carrying one of the tags
+  // its leaves look for.
+  bool looks_for_tags(const matcher_t& node)
+  {
+    switch (node.kind) {
+    case matcher_t::TAG:
+    case matcher_t::TAG_NAME:
+      return true;
+    case matcher_t::AND:
+    case matcher_t::OR:
+      return looks_for_tags(*node.left) && looks_for_tags(*node.right);
+    default:
+      return false;
+    }
+  }
+
+  void find_tag_terms(const matcher_t& node,
+                      std::vector<const matcher_t *>& terms)
+  {
+    if (node.kind == matcher_t::AND) {
+      find_tag_terms(*node.left, terms);
+      find_tag_terms(*node.right, terms);
+    }
+    else if (looks_for_tags(node)) {
+      terms.push_back(&node);
+    }
+  }
+
+  bool accepts_tag(const matcher_t& node, const string& name)
+  {
+    switch (node.kind) {
+    case matcher_t::TAG:
+      return node.mask.match(name);
+    case matcher_t::TAG_NAME:
+      // Tag names are compared without regard to case, as in the
+      // metadata of an item.
+      return boost::algorithm::iequals(name, node.operand.as_string());
+    default:
+      return (accepts_tag(*node.left, name) ||
+              accepts_tag(*node.right, name));
+    }
+  }
+
+  // The predicate need not have been compiled yet; its terms are
+  // recognized the same way in the tree as it was parsed.
+  shared_ptr<matcher_t> top_matcher(const shared_ptr<matcher_t>& matcher,
+                                    const expr_t::ptr_op_t&      op)
+  {
+    if (matcher)
+      return matcher;
+    return shared_ptr<matcher_t>(matcher_t::compile(op).release());
+  }
+
+  void find_accounts(account_t& parent,
+                     const std::vector<const matcher_t *>& terms,
+                     std::vector<account_t *>& accounts)
+  {
+    foreach (accounts_map::value_type& pair, parent.accounts) {
+      string fullname = pair.second->fullname();
+
+      bool admitted = true;
+      foreach (const matcher_t * term, terms) {
+        if (! test_account(*term, fullname)) {
+          admitted = false;
+          break;
+        }
+      }
+      if (admitted)
+        accounts.push_back(pair.second);
+
+      find_accounts(*pair.second, terms, accounts);
+    }
+  }
+}
+
+unique_ptr<matcher_t> matcher_t::compile(const expr_t::ptr_op_t& op)
+{
+  unique_ptr<matcher_t> node(compile_term(op));
+  if (! node) {
+    node.reset(new matcher_t(EXPR));
+    node->op      = op;
+    node->boolean = false;
+  }
+  return node;
+}
+
+bool matcher_t::test(post_t& post, scope_t& scope) const
+{
+  switch (kind) {
+  case CONSTANT:
+    return operand;
+
+  case ACCOUNT:
+    return mask.match(post.reported_account()->fullname());
+  case PAYEE:
+    return mask.match(post.payee());
+  case CODE:
+    return match_optional(mask, post.xact->code);
+  case NOTE:
+    if (post.note && post.xact->note)
+      return mask.match(*post.note + *post.xact->note);
+    return match_optional(mask, post.note ? post.note : post.xact->note);
+
+  case TAG:
+    return post.has_tag(mask, value_mask);
+  case TAG_NAME:
+    return post.has_tag(operand.as_string());
+
+  case DATE:
+    return compare_values(compare, post.date(), operand.as_date());
+
+  case AMOUNT: {
+    // This is what the "amount" of a posting evaluates to
+    value_t amount;
+    if (post.has_xdata() && post.xdata().has_flags(POST_EXT_COMPOUND))
+      amount = post.xdata().compound_value;
+    else if (post.amount.is_null())
+      amount = 0L;
+    else
+      amount = post.amount;
+    return compare_values(compare, amount, operand);
+  }
+
+  case NOT:
+    return ! left->test(post, scope);
+  case AND:
+    return left->test(post, scope) && right->test(post, scope);
+  case OR:
+    return left->test(post, scope) || right->test(post, scope);
+
+  case EXPR:
+    return op->calc(scope);
+  }
+  assert(false);
+  return false;
+}
+
+value_t matcher_t::calc(post_t& post, scope_t& scope) const
+{
+  if (boolean)
+    return test(post, scope);
+
+  switch (kind) {
+  case CONSTANT:
+    return operand;
+
+  case AND:
+    if (left->test(post, scope))
+      return right->calc(post, scope);
+    return false;
+
+  case OR:
+    if (value_t temp = left->calc(post, scope))
+      return temp;
+    return right->calc(post, scope);
+
+  case EXPR:
+    return op->calc(scope);
+
+  default:
+    assert(false);
+    return NULL_VALUE;
+  }
+}
+
+void predicate_t::compile(scope_t& scope)
+{
+  if (! compiled) {
+    expr_t::compile(scope);
+    if (ptr)
+      matcher = shared_ptr<matcher_t>(matcher_t::compile(ptr).release());
+    else
+      matcher.reset();
+  }
+}
+
+value_t predicate_t::real_calc(scope_t& scope)
+{
+  if (! *this)
+    return true;
+
+  // The posting must be the first scope consulted, so that the names in
+  // the expression mean what the matcher takes them to.
+  if (matcher) {
+    scope_t * item = scope.lookup_scope();
+    if (typeid(*item) == typeid(post_t) &&
+        scope.type_context() == value_t::VOID) {
+      post_t& post(static_cast<post_t&>(*item));
+      try {
+        if (matcher->boolean)
+          return matcher->test(post, scope);
+        else
+          return matcher->calc(post, scope)
+            .strip_annotations(what_to_keep).to_boolean();
+      }
+      catch (const std::exception&) {
+        // Evaluate the expression again below, so that the error is
+        // reported with the context of the full expression.
+        error_context();
+      }
+    }
+  }
+
+  return (expr_t::real_calc(scope)
+          .strip_annotations(what_to_keep)
+          .to_boolean());
+}
+
+bool predicate_t::is_thread_safe() const
+{
+  return matcher && matcher->boolean && matcher->is_thread_safe();
+}
+
+bool predicate_t::test(post_t& post, scope_t& scope) const
+{
+  assert(is_thread_safe());
+  return matcher->test(post, scope);
+}
+
+bool predicate_t::tests_account_only() const
+{
+  return matcher && matcher->tests_only(matcher_t::ACCOUNT);
+}
+
+bool predicate_t::tests_payee_only() const
+{
+  return matcher && matcher->tests_only(matcher_t::PAYEE);
+}
+
+void predicate_t::narrow_date_range(optional<date_t>& begin,
+                                    optional<date_t>& end) const
+{
+  if (ptr)
+    narrow_to(ptr, begin, end);
+}
+
+bool predicate_t::find_admitted_accounts
+  (account_t& master, std::vector<account_t *>& accounts) const
+{
+  if (! ptr)
+    return false;
+
+  std::vector<const matcher_t *> terms;
+  shared_ptr<matcher_t> node(top_matcher(matcher, ptr));
+  find_account_terms(*node, terms);
+  if (terms.empty())
+    return false;
+
+  find_accounts(master, terms, accounts);
+  return true;
+}
+
+bool predicate_t::tests_tags() const
+{
+  if (! ptr)
+    return false;
+
+  std::vector<const matcher_t *> terms;
+  shared_ptr<matcher_t> node(top_matcher(matcher, ptr));
+  find_tag_terms(*node, terms);
+  return ! terms.empty();
+}
+
+bool predicate_t::find_admitted_tags
+  (const std::vector<string>&         tags,
+   std::vector<std::vector<string> >& admitted) const
+{
+  if (! ptr)
+    return false;
+
+  std::vector<const matcher_t *> terms;
+  shared_ptr<matcher_t> node(top_matcher(matcher, ptr));
+  find_tag_terms(*node, terms);
+  if (terms.empty())
+    return false;
+
+  foreach (const matcher_t * term, terms) {
+    admitted.push_back(std::vector<string>());
+    foreach (const string& name, tags)
+      if (accepts_tag(*term, name))
+        admitted.back().push_back(name);
+  }
+  return true;
+}
+
+} // namespace ledger
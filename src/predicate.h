@@ -48,10 +48,16 @@
 
 namespace ledger {
 
+class account_t;
+class post_t;
+
 class predicate_t : public expr_t
 {
 public:
-  keep_details_t what_to_keep;
+  class matcher_t;
+
+  keep_details_t        what_to_keep;
+  shared_ptr<matcher_t> matcher;
 
   predicate_t(const keep_details_t& _what_to_keep = keep_details_t())
     : what_to_keep(_what_to_keep) {
@@ -83,13 +89,76 @@ public:
     TRACE_DTOR(predicate_t);
   }
 
-  virtual value_t real_calc(scope_t& scope) {
-    return (*this ?
-            expr_t::real_calc(scope)
-              .strip_annotations(what_to_keep)
-              .to_boolean() :
-            true);
-  }
+  /**
+   * After compiling the expression tree, the terms that only test a
+   * posting's account, payee, code, note, tags, date or amount are turned
+   * into a matcher_t, which tests a posting directly.  Other terms stay
+   * expression trees and are calculated as before.
+   */
+  virtual void compile(scope_t& scope);
+
+  virtual value_t real_calc(scope_t& scope);
+
+  /**
+   * True if the predicate has been compiled into tests which neither
+   * evaluate expressions nor copy amounts, so that several threads may
+   * use test() at once on postings of different transactions.
+   */
+  bool is_thread_safe() const;
+
+  /**
+   * Tests a posting without evaluating any expression.  Only valid if
+   * is_thread_safe().
+   */
+  bool test(post_t& post, scope_t& scope) const;
+
+  /**
+   * True if the predicate has been compiled and depends on nothing but
+   * the name of a posting's account, so that its result may be
+   * remembered for each account.
+   */
+  bool tests_account_only() const;
+
+  /**
+   * True if the predicate has been compiled and depends on nothing but
+   * the payee of a posting.
+   */
+  bool tests_payee_only() const;
+
+  /**
+   * Narrows [begin, end) to the dates within which the predicate requires
+   * a posting's date to fall.  Only comparisons of the date against a
+   * constant, joined to the rest of the predicate by "and", are
+   * considered.
+   */
+  void narrow_date_range(optional<date_t>& begin,
+                         optional<date_t>& end) const;
+
+  /**
+   * Appends to `accounts' every account below `master' whose name passes
+   * the tests of the predicate that look only at the account, and are
+   * joined to the rest of it by "and".  Postings of other accounts can
+   * never satisfy the predicate.  Returns false, appending nothing, if
+   * there are no such tests.
+   */
+  bool find_admitted_accounts(account_t&                 master,
+                              std::vector<account_t *>& accounts) const;
+
+  /**
+   * True if any test joined to the rest of the predicate by "and" only
+   * looks for tags, so that find_admitted_tags() would return true.
+   */
+  bool tests_tags() const;
+
+  /**
+   * For each test joined to the rest of the predicate by "and" which
+   * only looks for tags, appends to `admitted' the names among `tags'
+   * that it accepts.  A posting carrying none of those, itself or
+   * through its transaction, can never satisfy the predicate.  Returns
+   * false if there are no such tests.
+   */
+  bool find_admitted_tags(const std::vector<string>&         tags,
+                          std::vector<std::vector<string> >& admitted) const;
 };
 
 } // namespace ledger
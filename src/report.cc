@@ -344,6 +344,218 @@ namespace {
   };
 }
 
+namespace {
+  struct posts_streamer
+  {
+    post_handler_ptr handler;
+
+    posts_streamer(post_handler_ptr _handler) : handler(_handler) {
+      TRACE_CTOR(posts_streamer, "post_handler_ptr");
+    }
+    posts_streamer(const posts_streamer& other) : handler(other.handler) {
+      TRACE_CTOR(posts_streamer, "copy");
+    }
+    ~posts_streamer() throw() {
+      TRACE_DTOR(posts_streamer);
+    }
+
+    void operator()(xact_t& xact) {
+      foreach (post_t * post, xact.posts) {
+        try {
+          (*handler)(*post);
+        }
+        catch (const std::exception&) {
+          add_error_context(item_context(*post, _("While handling posting")));
+          throw;
+        }
+      }
+    }
+  };
+
+  std::size_t count_posts(const account_t& account)
+  {
+    std::size_t count = account.posts.size();
+    foreach (const accounts_map::value_type& pair, account.accounts)
+      count += count_posts(*pair.second);
+    return count;
+  }
+
+  std::size_t count_posts(const xacts_list& xacts)
+  {
+    std::size_t count = 0;
+    foreach (const xact_t * xact, xacts)
+      count += xact->posts.size();
+    return count;
+  }
+
+  bool has_no_posts(const account_t * account)
+  {
+    return account->posts.empty();
+  }
+
+  string describe_range(const optional<date_t>& begin,
+                        const optional<date_t>& end)
+  {
+    std::ostringstream out;
+    if (begin)
+      out << " from " << format_date(*begin, FMT_WRITTEN);
+    if (end)
+      out << " before " << format_date(*end, FMT_WRITTEN);
+    return out.str();
+  }
+
+  // Postings which fail the --limit predicate would only be thrown away
+  // by the filter_posts which chain_pre_post_handlers puts first, so
+  // the walk of the journal is planned to leave out as many of them as
+  // the predicate allows.  Of these plans, the one visiting the fewest
+  // postings is chosen:
+  //
+  // - If it only admits postings of some accounts, the postings of those
+  //   accounts are gathered and put back into journal order.  As this
+  //   costs more than walking transactions, their postings are counted
+  //   twice.
+  // - If it only admits postings carrying certain tags, only the
+  //   transactions carrying those tags, or having postings which do, are
+  //   visited.
+  // - If it only admits postings dated within a range, only the
+  //   transactions having a date in that range are visited.
+  // - Otherwise every transaction is.
+  //
+  // The filter still decides which of the postings visited are reported.
+  void plan_journal_walk(report_t& report, journal_posts_iterator& walker)
+  {
+    journal_t& journal(*report.session.journal.get());
+
+    optional<date_t>                  begin;
+    optional<date_t>                  end;
+    std::vector<account_t *>          accounts;
+    std::vector<std::vector<string> > tags;
+    bool                              by_account = false;
+    bool                              by_tag     = false;
+    if (report.HANDLED(limit_)) {
+      predicate_t limit(report.HANDLER(limit_).str(), report.what_to_keep());
+      limit.narrow_date_range(begin, end);
+      by_account = limit.find_admitted_accounts(*journal.master, accounts);
+      // The journal's tag names are only gathered when they are needed
+      if (limit.tests_tags())
+        by_tag = limit.find_admitted_tags(journal.tag_names(), tags);
+    }
+
+    enum { ALL, BY_DATE, BY_TAG, BY_ACCOUNT } plan = ALL;
+    std::size_t total  = count_posts(*journal.master);
+    std::size_t least  = total;
+    xacts_list  chosen;
+
+    if (begin || end) {
+      xacts_list  in_range(journal.xacts_in_range(begin, end));
+      std::size_t dated = count_posts(in_range);
+      if (dated < least) {
+        plan  = BY_DATE;
+        least = dated;
+        chosen.swap(in_range);
+      }
+    }
+
+    if (by_tag) {
+      xacts_list  with_tags(journal.xacts_with_tags(tags));
+      std::size_t tagged = count_posts(with_tags);
+      if (tagged < least) {
+        plan  = BY_TAG;
+        least = tagged;
+        chosen.swap(with_tags);
+      }
+    }
+
+    if (by_account) {
+      accounts.erase(std::remove_if(accounts.begin(), accounts.end(),
+                                    has_no_posts), accounts.end());
+      std::size_t in_accounts = 0;
+      foreach (const account_t * account, accounts)
+        in_accounts += account->posts.size();
+      if (in_accounts * 2 < least) {
+        plan  = BY_ACCOUNT;
+        least = in_accounts;
+      }
+    }
+
+    std::ostream * explain = NULL;
+    if (report.HANDLED(explain_plan)) {
+      explain = &std::cerr;
+      if (report.HANDLED(limit_))
+        *explain << "--- Plan for: " << report.HANDLER(limit_).str()
+                 << " ---" << std::endl;
+      else
+        *explain << "--- Plan ---" << std::endl;
+    }
+
+    switch (plan) {
+    case BY_ACCOUNT: {
+      posts_list posts(journal.account_posts_in_range(accounts, begin, end));
+      if (explain) {
+        *explain << "Postings of " << accounts.size()
+                 << (accounts.size() == 1 ? " account" : " accounts")
+                 << describe_range(begin, end) << " (" << posts.size()
+                 << " of " << total << " postings)" << std::endl;
+        foreach (const account_t * account, accounts)
+          *explain << "  " << account->fullname() << std::endl;
+      }
+      walker.reset(posts);
+      break;
+    }
+
+    case BY_TAG:
+      if (explain) {
+        *explain << "Transactions tagged (" << least << " of " << total
+                 << " postings)" << std::endl;
+        foreach (const std::vector<string>& names, tags) {
+          *explain << " ";
+          foreach (const string& name, names)
+            *explain << " " << name;
+          if (names.empty())
+            *explain << " (none)";
+          *explain << std::endl;
+        }
+      }
+      walker.reset(chosen);
+      break;
+
+    case BY_DATE:
+      if (explain)
+        *explain << "Transactions dated" << describe_range(begin, end)
+                 << " (" << least << " of " << total << " postings)"
+                 << std::endl;
+      walker.reset(chosen);
+      break;
+
+    case ALL:
+      if (explain)
+        *explain << "All transactions (" << total << " postings)"
+                 << std::endl;
+      walker.reset(journal);
+      break;
+    }
+  }
+}
+
+bool report_t::can_stream_journal(const string& verb)
+{
+  // Only a register report can be printed while the journal is still
+  // being read.  Sorting, truncating, grouping or subtotalling it needs
+  // every posting first, valuation needs prices that may appear later
+  // in the journal, and a balance report gathers its totals from each
+  // account's postings once they have all been seen.
+  if (! (verb == "r" || verb == "reg" || verb == "register"))
+    return false;
+
+  return ! (HANDLED(sort_) || HANDLED(head_) || HANDLED(tail_) ||
+            HANDLED(group_by_) || HANDLED(period_) || HANDLED(subtotal) ||
+            HANDLED(equity) || HANDLED(by_payee) || HANDLED(dow) ||
+            HANDLED(related) || HANDLED(inject_) ||
+            HANDLED(forecast_while_) || budget_flags != BUDGET_NO_BUDGET ||
+            HANDLED(market) || HANDLED(exchange_) || HANDLED(historical) ||
+            HANDLED(gain) || HANDLED(revalued) || session.HANDLED(cache_));
+}
+
 void report_t::posts_report(post_handler_ptr handler)
 {
   handler = chain_post_handlers(handler, *this);
@@ -355,8 +567,24 @@ void report_t::posts_report(post_handler_ptr handler)
   }
   handler = chain_pre_post_handlers(handler, *this);
 
-  journal_posts_iterator walker(*session.journal.get());
-  pass_down_posts<journal_posts_iterator>(handler, walker);
+  if (HANDLED(stream) && ! session.journal->was_loaded) {
+    // The journal was left unread for us by global_scope_t, so that each
+    // transaction can be reported as soon as it is parsed.
+    session.journal->xact_streamer = posts_streamer(handler);
+    try {
+      session.read_journal_files();
+    }
+    catch (...) {
+      session.journal->finish_streaming();
+      throw;
+    }
+    session.journal->finish_streaming();
+    handler->flush();
+  } else {
+    journal_posts_iterator walker;
+    plan_journal_walk(*this, walker);
+    pass_down_posts<journal_posts_iterator>(handler, walker);
+  }
 
   if (! HANDLED(group_by_))
     posts_flusher(handler, *this)(value_t());
@@ -476,11 +704,18 @@ void report_t::accounts_report(acct_handler_ptr handler)
   // The lifetime of the chain object controls the lifetime of all temporary
   // objects created within it during the call to pass_down_posts, which will
   // be needed later by the pass_down_accounts.
-  journal_posts_iterator walker(*session.journal.get());
+  journal_posts_iterator walker;
+  plan_journal_walk(*this, walker);
   pass_down_posts<journal_posts_iterator>(chain, walker);
 
-  if (! HANDLED(group_by_))
+  if (! HANDLED(group_by_)) {
+    if (HANDLED(threads_) && ! DO_VERIFY()) {
+      std::size_t threads = lexical_cast<std::size_t>(HANDLER(threads_).str());
+      if (threads > 1)
+        sum_accounts(*session.journal->master, threads);
+    }
     accounts_flusher(handler, *this)(value_t());
+  }
 }
 
 void report_t::commodities_report(post_handler_ptr handler)
@@ -1023,8 +1258,7 @@ namespace {
 
 value_t report_t::reload_command(call_scope_t&)
 {
-  session.close_journal_files();
-  session.read_journal_files();
+  session.reload_journal_files();
   return true;
 }
 
@@ -1046,264 +1280,274 @@ value_t report_t::pricemap_command(call_scope_t& args)
 
 option_t<report_t> * report_t::lookup_option(const char * p)
 {
-  switch (*p) {
-  case '%':
-    OPT_CH(percent);
-    break;
-  case 'A':
-    OPT_CH(average);
-    break;
-  case 'B':
-    OPT_CH(basis);
-    break;
-  case 'C':
-    OPT_CH(cleared);
-    break;
-  case 'D':
-    OPT_CH(daily);
-    break;
-  case 'E':
-    OPT_CH(empty);
-    break;
-  case 'F':
-    OPT_CH(format_);
-    break;
-  case 'G':
-    OPT_CH(gain);
-    break;
-  case 'H':
-    OPT_CH(historical);
-    break;
-  case 'I':
-    OPT_CH(price);
-    break;
-  case 'J':
-    OPT_CH(total_data);
-    break;
-  case 'L':
-    OPT_CH(actual);
-    break;
-  case 'M':
-    OPT_CH(monthly);
-    break;
-  case 'O':
-    OPT_CH(quantity);
-    break;
-  case 'P':
-    OPT_CH(by_payee);
-    break;
-  case 'R':
-    OPT_CH(real);
-    break;
-  case 'S':
-    OPT_CH(sort_);
-    break;
-  case 'T':
-    OPT_CH(total_);
-    break;
-  case 'U':
-    OPT_CH(uncleared);
-    break;
-  case 'V':
-    OPT_CH(market);
-    break;
-  case 'W':
-    OPT_CH(weekly);
-    break;
-  case 'X':
-    OPT_CH(exchange_);
-    break;
-  case 'Y':
-    OPT_CH(yearly);
-    break;
-  case 'a':
-    OPT(abbrev_len_);
-    else OPT_(account_);
-    else OPT(actual);
-    else OPT(add_budget);
-    else OPT(amount_);
-    else OPT(amount_data);
-    else OPT_ALT(primary_date, actual_dates);
-    else OPT(anon);
-    else OPT_ALT(color, ansi);
-    else OPT(auto_match);
-    else OPT(aux_date);
-    else OPT(average);
-    else OPT(account_width_);
-    else OPT(amount_width_);
-    break;
-  case 'b':
-    OPT(balance_format_);
-    else OPT(base);
-    else OPT(basis);
-    else OPT_(begin_);
-    else OPT(bold_if_);
-    else OPT(budget);
-    else OPT(budget_format_);
-    else OPT(by_payee);
-    break;
-  case 'c':
-    OPT(csv_format_);
-    else OPT_ALT(gain, change);
-    else OPT(cleared);
-    else OPT(cleared_format_);
-    else OPT(collapse);
-    else OPT(collapse_if_zero);
-    else OPT(color);
-    else OPT(columns_);
-    else OPT_ALT(basis, cost);
-    else OPT_(current);
-    else OPT(count);
-    break;
-  case 'd':
-    OPT(daily);
-    else OPT(date_);
-    else OPT(date_format_);
-    else OPT(datetime_format_);
-    else OPT(dc);
-    else OPT(depth_);
-    else OPT(deviation);
-    else OPT_ALT(rich_data, detail);
-    else OPT_(display_);
-    else OPT(display_amount_);
-    else OPT(display_total_);
-    else OPT_ALT(dow, days_of_week);
-    else OPT(date_width_);
-    break;
-  case 'e':
-    OPT(empty);
-    else OPT_(end_);
-    else OPT(equity);
-    else OPT(exact);
-    else OPT(exchange_);
-    else OPT_ALT(aux_date, effective);
-    break;
-  case 'f':
-    OPT(flat);
-    else OPT_ALT(forecast_while_, forecast_);
-    else OPT(forecast_years_);
-    else OPT(format_);
-    else OPT(force_color);
-    else OPT(force_pager);
-    else OPT_ALT(head_, first_);
-    break;
-  case 'g':
-    OPT(gain);
-    else OPT(group_by_);
-    else OPT(group_title_format_);
-    else OPT(generated);
-    break;
-  case 'h':
-    OPT(head_);
-    else OPT(historical);
-    break;
-  case 'i':
-    OPT(invert);
-    else OPT(inject_);
-    else OPT(immediate);
-    break;
-  case 'j':
-    OPT_CH(amount_data);
-    break;
-  case 'l':
-    OPT_(limit_);
-    else OPT(lot_dates);
-    else OPT(lot_prices);
-    else OPT_ALT(lot_notes, lot_tags);
-    else OPT(lots);
-    else OPT(lots_actual);
-    else OPT_ALT(tail_, last_);
-    break;
-  case 'm':
-    OPT(market);
-    else OPT(monthly);
-    else OPT(meta_);
-    else OPT(meta_width_);
-    break;
-  case 'n':
-    OPT_CH(collapse);
-    else OPT(no_color);
-    else OPT(no_pager);
-    else OPT(no_revalued);
-    else OPT(no_rounding);
-    else OPT(no_titles);
-    else OPT(no_total);
-    else OPT(now_);
-    break;
-  case 'o':
-    OPT(only_);
-    else OPT_(output_);
-    break;
-  case 'p':
-    OPT(pager_);
-    else OPT(payee_);
-    else OPT(pending);
-    else OPT(percent);
-    else OPT_(period_);
-    else OPT_ALT(sort_xacts_, period_sort_);
-    else OPT(pivot_);
-    else OPT(plot_amount_format_);
-    else OPT(plot_total_format_);
-    else OPT(price);
-    else OPT(prices_format_);
-    else OPT(pricedb_format_);
-    else OPT(primary_date);
-    else OPT(payee_width_);
-    else OPT(prepend_format_);
-    else OPT(prepend_width_);
-    break;
-  case 'q':
-    OPT(quantity);
-    else OPT(quarterly);
-    break;
-  case 'r':
-    OPT(raw);
-    else OPT(real);
-    else OPT(register_format_);
-    else OPT_(related);
-    else OPT(related_all);
-    else OPT(revalued);
-    else OPT(revalued_only);
-    else OPT(revalued_total_);
-    else OPT(rich_data);
-    break;
-  case 's':
-    OPT(sort_);
-    else OPT(sort_all_);
-    else OPT(sort_xacts_);
-    else OPT_(subtotal);
-    else OPT(start_of_week_);
-    else OPT(seed_);
-    break;
-  case 't':
-    OPT_CH(amount_);
-    else OPT(tail_);
-    else OPT(total_);
-    else OPT(total_data);
-    else OPT(truncate_);
-    else OPT(total_width_);
-    else OPT(time_report);
-    break;
-  case 'u':
-    OPT(unbudgeted);
-    else OPT(uncleared);
-    else OPT(unrealized);
-    else OPT(unrealized_gains_);
-    else OPT(unrealized_losses_);
-    else OPT(unround);
-    break;
-  case 'v':
-    OPT_ALT(market, value);
-    else OPT(values);
-    break;
-  case 'w':
-    OPT(weekly);
-    else OPT_(wide);
-    break;
-  case 'y':
-    OPT_CH(date_format_);
-    else OPT(yearly);
-    break;
+  // Single letter options, optionally followed by the _ that marks a
+  // wanted argument.
+  if (*p && (! *(p + 1) || (*(p + 1) == '_' && ! *(p + 2)))) {
+    switch (*p) {
+    case '%':
+      OPT_CH(percent);
+      break;
+    case 'A':
+      OPT_CH(average);
+      break;
+    case 'B':
+      OPT_CH(basis);
+      break;
+    case 'C':
+      OPT_CH(cleared);
+      break;
+    case 'D':
+      OPT_CH(daily);
+      break;
+    case 'E':
+      OPT_CH(empty);
+      break;
+    case 'F':
+      OPT_CH(format_);
+      break;
+    case 'G':
+      OPT_CH(gain);
+      break;
+    case 'H':
+      OPT_CH(historical);
+      break;
+    case 'I':
+      OPT_CH(price);
+      break;
+    case 'J':
+      OPT_CH(total_data);
+      break;
+    case 'L':
+      OPT_CH(actual);
+      break;
+    case 'M':
+      OPT_CH(monthly);
+      break;
+    case 'O':
+      OPT_CH(quantity);
+      break;
+    case 'P':
+      OPT_CH(by_payee);
+      break;
+    case 'R':
+      OPT_CH(real);
+      break;
+    case 'S':
+      OPT_CH(sort_);
+      break;
+    case 'T':
+      OPT_CH(total_);
+      break;
+    case 'U':
+      OPT_CH(uncleared);
+      break;
+    case 'V':
+      OPT_CH(market);
+      break;
+    case 'W':
+      OPT_CH(weekly);
+      break;
+    case 'X':
+      OPT_CH(exchange_);
+      break;
+    case 'Y':
+      OPT_CH(yearly);
+      break;
+    case 'a':
+      OPT_CH(account_);
+      break;
+    case 'b':
+      OPT_CH(begin_);
+      break;
+    case 'c':
+      OPT_CH(current);
+      break;
+    case 'd':
+      OPT_CH(display_);
+      break;
+    case 'e':
+      OPT_CH(end_);
+      break;
+    case 'j':
+      OPT_CH(amount_data);
+      break;
+    case 'l':
+      OPT_CH(limit_);
+      break;
+    case 'n':
+      OPT_CH(collapse);
+      break;
+    case 'o':
+      OPT_CH(output_);
+      break;
+    case 'p':
+      OPT_CH(period_);
+      break;
+    case 'r':
+      OPT_CH(related);
+      break;
+    case 's':
+      OPT_CH(subtotal);
+      break;
+    case 't':
+      OPT_CH(amount_);
+      break;
+    case 'w':
+      OPT_CH(wide);
+      break;
+    case 'y':
+      OPT_CH(date_format_);
+      break;
+    }
+    return NULL;
+  }
+
+  switch (hash_name(p)) {
+  OPT_CASE(abbrev_len_);
+  OPT_CASE(account_);
+  OPT_CASE(account_width_);
+  OPT_CASE(actual);
+  OPT_ALT_CASE(primary_date, actual_dates);
+  OPT_CASE(add_budget);
+  OPT_CASE(amount_);
+  OPT_CASE(amount_data);
+  OPT_CASE(amount_width_);
+  OPT_CASE(anon);
+  OPT_ALT_CASE(color, ansi);
+  OPT_CASE(auto_match);
+  OPT_CASE(aux_date);
+  OPT_CASE(average);
+  OPT_CASE(balance_format_);
+  OPT_CASE(base);
+  OPT_CASE(basis);
+  OPT_CASE(begin_);
+  OPT_CASE(bold_if_);
+  OPT_CASE(budget);
+  OPT_CASE(budget_format_);
+  OPT_CASE(by_payee);
+  OPT_ALT_CASE(gain, change);
+  OPT_CASE(cleared);
+  OPT_CASE(cleared_format_);
+  OPT_CASE(collapse);
+  OPT_CASE(collapse_if_zero);
+  OPT_CASE(color);
+  OPT_CASE(columns_);
+  OPT_ALT_CASE(basis, cost);
+  OPT_CASE(count);
+  OPT_CASE(csv_format_);
+  OPT_CASE(current);
+  OPT_CASE(daily);
+  OPT_CASE(date_);
+  OPT_CASE(date_format_);
+  OPT_CASE(date_width_);
+  OPT_CASE(datetime_format_);
+  OPT_ALT_CASE(dow, days_of_week);
+  OPT_CASE(dc);
+  OPT_CASE(depth_);
+  OPT_ALT_CASE(rich_data, detail);
+  OPT_CASE(deviation);
+  OPT_CASE(display_);
+  OPT_CASE(display_amount_);
+  OPT_CASE(display_total_);
+  OPT_CASE(dow);
+  OPT_ALT_CASE(aux_date, effective);
+  OPT_CASE(empty);
+  OPT_CASE(end_);
+  OPT_CASE(equity);
+  OPT_CASE(exact);
+  OPT_CASE(exchange_);
+  OPT_CASE(explain_expr);
+  OPT_CASE(explain_plan);
+  OPT_ALT_CASE(head_, first_);
+  OPT_CASE(flat);
+  OPT_CASE(force_color);
+  OPT_CASE(force_pager);
+  OPT_ALT_CASE(forecast_while_, forecast_);
+  OPT_CASE(forecast_while_);
+  OPT_CASE(forecast_years_);
+  OPT_CASE(format_);
+  OPT_CASE(gain);
+  OPT_CASE(generated);
+  OPT_CASE(group_by_);
+  OPT_CASE(group_title_format_);
+  OPT_CASE(head_);
+  OPT_CASE(historical);
+  OPT_CASE(immediate);
+  OPT_CASE(inject_);
+  OPT_CASE(invert);
+  OPT_ALT_CASE(tail_, last_);
+  OPT_CASE(limit_);
+  OPT_CASE(lot_dates);
+  OPT_CASE(lot_notes);
+  OPT_CASE(lot_prices);
+  OPT_ALT_CASE(lot_notes, lot_tags);
+  OPT_CASE(lots);
+  OPT_CASE(lots_actual);
+  OPT_CASE(market);
+  OPT_CASE(meta_);
+  OPT_CASE(meta_width_);
+  OPT_CASE(monthly);
+  OPT_CASE(no_color);
+  OPT_CASE(no_pager);
+  OPT_CASE(no_revalued);
+  OPT_CASE(no_rounding);
+  OPT_CASE(no_titles);
+  OPT_CASE(no_total);
+  OPT_CASE(now_);
+  OPT_CASE(only_);
+  OPT_CASE(output_);
+  OPT_CASE(pager_);
+  OPT_CASE(payee_);
+  OPT_CASE(payee_width_);
+  OPT_CASE(pending);
+  OPT_CASE(percent);
+  OPT_CASE(period_);
+  OPT_ALT_CASE(sort_xacts_, period_sort_);
+  OPT_CASE(pivot_);
+  OPT_CASE(plot_amount_format_);
+  OPT_CASE(plot_total_format_);
+  OPT_CASE(prepend_format_);
+  OPT_CASE(prepend_width_);
+  OPT_CASE(price);
+  OPT_CASE(pricedb_format_);
+  OPT_CASE(prices_format_);
+  OPT_CASE(primary_date);
+  OPT_CASE(quantity);
+  OPT_CASE(quarterly);
+  OPT_CASE(raw);
+  OPT_CASE(real);
+  OPT_CASE(register_format_);
+  OPT_CASE(related);
+  OPT_CASE(related_all);
+  OPT_CASE(revalued);
+  OPT_CASE(revalued_only);
+  OPT_CASE(revalued_total_);
+  OPT_CASE(rich_data);
+  OPT_CASE(seed_);
+  OPT_CASE(sort_);
+  OPT_CASE(sort_all_);
+  OPT_CASE(sort_xacts_);
+  OPT_CASE(start_of_week_);
+  OPT_CASE(stream);
+  OPT_CASE(subtotal);
+  OPT_CASE(tail_);
+  OPT_CASE(threads_);
+  OPT_CASE(time_report);
+  OPT_CASE(total_);
+  OPT_CASE(total_data);
+  OPT_CASE(total_width_);
+  OPT_CASE(truncate_);
+  OPT_CASE(unbudgeted);
+  OPT_CASE(uncleared);
+  OPT_CASE(unrealized);
+  OPT_CASE(unrealized_gains_);
+  OPT_CASE(unrealized_losses_);
+  OPT_CASE(unround);
+  OPT_ALT_CASE(market, value);
+  OPT_CASE(values);
+  OPT_CASE(weekly);
+  OPT_CASE(wide);
+  OPT_CASE(yearly);
   }
   return NULL;
 }
@@ -1363,194 +1607,280 @@ expr_t::ptr_op_t report_t::lookup(const symbol_t::kind_t kind,
       }
     }
 
-    switch (*p) {
-    case 'a':
+    switch (hash_name(p)) {
+    case hash_name("amount_expr"):
       if (is_eq(p, "amount_expr"))
         return MAKE_FUNCTOR(report_t::fn_amount_expr);
-      else if (is_eq(p, "ansify_if"))
+      break;
+    case hash_name("ansify_if"):
+      if (is_eq(p, "ansify_if"))
         return MAKE_FUNCTOR(report_t::fn_ansify_if);
-      else if (is_eq(p, "abs"))
+      break;
+    case hash_name("abs"):
+      if (is_eq(p, "abs"))
         return MAKE_FUNCTOR(report_t::fn_abs);
       break;
 
-    case 'b':
+    case hash_name("black"):
       if (is_eq(p, "black"))
         return WRAP_FUNCTOR(fn_black);
-      else if (is_eq(p, "blink"))
+      break;
+    case hash_name("blink"):
+      if (is_eq(p, "blink"))
         return WRAP_FUNCTOR(fn_blink);
-      else if (is_eq(p, "blue"))
+      break;
+    case hash_name("blue"):
+      if (is_eq(p, "blue"))
         return WRAP_FUNCTOR(fn_blue);
-      else if (is_eq(p, "bold"))
+      break;
+    case hash_name("bold"):
+      if (is_eq(p, "bold"))
         return WRAP_FUNCTOR(fn_bold);
       break;
 
-    case 'c':
+    case hash_name("cyan"):
       if (is_eq(p, "cyan"))
         return WRAP_FUNCTOR(fn_cyan);
-      else if (is_eq(p, "commodity"))
+      break;
+    case hash_name("commodity"):
+      if (is_eq(p, "commodity"))
         return MAKE_FUNCTOR(report_t::fn_commodity);
-      else if (is_eq(p, "ceiling"))
+      break;
+    case hash_name("ceiling"):
+      if (is_eq(p, "ceiling"))
         return MAKE_FUNCTOR(report_t::fn_ceiling);
-      else if (is_eq(p, "clear_commodity"))
+      break;
+    case hash_name("clear_commodity"):
+      if (is_eq(p, "clear_commodity"))
         return MAKE_FUNCTOR(report_t::fn_clear_commodity);
       break;
 
-    case 'd':
+    case hash_name("display_amount"):
       if (is_eq(p, "display_amount"))
         return MAKE_FUNCTOR(report_t::fn_display_amount);
-      else if (is_eq(p, "display_total"))
+      break;
+    case hash_name("display_total"):
+      if (is_eq(p, "display_total"))
         return MAKE_FUNCTOR(report_t::fn_display_total);
-      else if (is_eq(p, "date"))
+      break;
+    case hash_name("date"):
+      if (is_eq(p, "date"))
         return MAKE_FUNCTOR(report_t::fn_today);
       break;
 
-    case 'f':
+    case hash_name("format_date"):
       if (is_eq(p, "format_date"))
         return MAKE_FUNCTOR(report_t::fn_format_date);
-      else if (is_eq(p, "format_datetime"))
+      break;
+    case hash_name("format_datetime"):
+      if (is_eq(p, "format_datetime"))
         return MAKE_FUNCTOR(report_t::fn_format_datetime);
-      else if (is_eq(p, "format"))
+      break;
+    case hash_name("format"):
+      if (is_eq(p, "format"))
         return MAKE_FUNCTOR(report_t::fn_format);
-      else if (is_eq(p, "floor"))
+      break;
+    case hash_name("floor"):
+      if (is_eq(p, "floor"))
         return MAKE_FUNCTOR(report_t::fn_floor);
       break;
 
-    case 'g':
+    case hash_name("get_at"):
       if (is_eq(p, "get_at"))
         return MAKE_FUNCTOR(report_t::fn_get_at);
-      else if (is_eq(p, "green"))
+      break;
+    case hash_name("green"):
+      if (is_eq(p, "green"))
         return WRAP_FUNCTOR(fn_green);
       break;
 
-    case 'i':
+    case hash_name("is_seq"):
       if (is_eq(p, "is_seq"))
         return MAKE_FUNCTOR(report_t::fn_is_seq);
       break;
 
-    case 'j':
+    case hash_name("justify"):
       if (is_eq(p, "justify"))
         return MAKE_FUNCTOR(report_t::fn_justify);
-      else if (is_eq(p, "join"))
+      break;
+    case hash_name("join"):
+      if (is_eq(p, "join"))
         return MAKE_FUNCTOR(report_t::fn_join);
       break;
 
-    case 'm':
+    case hash_name("market"):
       if (is_eq(p, "market"))
         return MAKE_FUNCTOR(report_t::fn_market);
-      else if (is_eq(p, "magenta"))
+      break;
+    case hash_name("magenta"):
+      if (is_eq(p, "magenta"))
         return WRAP_FUNCTOR(fn_magenta);
       break;
 
-    case 'n':
+    case hash_name("null"):
       if (is_eq(p, "null"))
         return WRAP_FUNCTOR(fn_null);
-      else if (is_eq(p, "now"))
+      break;
+    case hash_name("now"):
+      if (is_eq(p, "now"))
         return MAKE_FUNCTOR(report_t::fn_now);
-      else if (is_eq(p, "nail_down"))
+      break;
+    case hash_name("nail_down"):
+      if (is_eq(p, "nail_down"))
         return MAKE_FUNCTOR(report_t::fn_nail_down);
       break;
 
-    case 'o':
+    case hash_name("options"):
       if (is_eq(p, "options"))
         return MAKE_FUNCTOR(report_t::fn_options);
       break;
 
-    case 'p':
+    case hash_name("post"):
       if (is_eq(p, "post"))
         return WRAP_FUNCTOR(fn_false);
-      else if (is_eq(p, "percent"))
+      break;
+    case hash_name("percent"):
+      if (is_eq(p, "percent"))
         return MAKE_FUNCTOR(report_t::fn_percent);
-      else if (is_eq(p, "print"))
+      break;
+    case hash_name("print"):
+      if (is_eq(p, "print"))
         return MAKE_FUNCTOR(report_t::fn_print);
       break;
 
-    case 'q':
+    case hash_name("quoted"):
       if (is_eq(p, "quoted"))
         return MAKE_FUNCTOR(report_t::fn_quoted);
-      else if (is_eq(p, "quoted_rfc4180"))
+      break;
+    case hash_name("quoted_rfc4180"):
+      if (is_eq(p, "quoted_rfc4180"))
         return MAKE_FUNCTOR(report_t::fn_quoted_rfc4180);
-      else if (is_eq(p, "quantity"))
+      break;
+    case hash_name("quantity"):
+      if (is_eq(p, "quantity"))
         return MAKE_FUNCTOR(report_t::fn_quantity);
       break;
 
-    case 'r':
+    case hash_name("rounded"):
       if (is_eq(p, "rounded"))
         return MAKE_FUNCTOR(report_t::fn_rounded);
-      else if (is_eq(p, "red"))
+      break;
+    case hash_name("red"):
+      if (is_eq(p, "red"))
         return WRAP_FUNCTOR(fn_red);
-      else if (is_eq(p, "round"))
+      break;
+    case hash_name("round"):
+      if (is_eq(p, "round"))
         return MAKE_FUNCTOR(report_t::fn_round);
-      else if (is_eq(p, "roundto"))
+      break;
+    case hash_name("roundto"):
+      if (is_eq(p, "roundto"))
         return MAKE_FUNCTOR(report_t::fn_roundto);
       break;
 
-    case 's':
+    case hash_name("scrub"):
       if (is_eq(p, "scrub"))
         return MAKE_FUNCTOR(report_t::fn_scrub);
-      else if (is_eq(p, "strip"))
+      break;
+    case hash_name("strip"):
+      if (is_eq(p, "strip"))
         return MAKE_FUNCTOR(report_t::fn_strip);
-      else if (is_eq(p, "should_bold"))
+      break;
+    case hash_name("should_bold"):
+      if (is_eq(p, "should_bold"))
         return MAKE_FUNCTOR(report_t::fn_should_bold);
       break;
 
-    case 't':
+    case hash_name("truncated"):
       if (is_eq(p, "truncated"))
         return MAKE_FUNCTOR(report_t::fn_truncated);
-      else if (is_eq(p, "total_expr"))
+      break;
+    case hash_name("total_expr"):
+      if (is_eq(p, "total_expr"))
         return MAKE_FUNCTOR(report_t::fn_total_expr);
-      else if (is_eq(p, "today"))
+      break;
+    case hash_name("today"):
+      if (is_eq(p, "today"))
         return MAKE_FUNCTOR(report_t::fn_today);
-      else if (is_eq(p, "t"))
+      break;
+    case hash_name("t"):
+      if (is_eq(p, "t"))
         return MAKE_FUNCTOR(report_t::fn_display_amount);
-      else if (is_eq(p, "trim"))
+      break;
+    case hash_name("trim"):
+      if (is_eq(p, "trim"))
         return MAKE_FUNCTOR(report_t::fn_trim);
-      else if (is_eq(p, "top_amount"))
+      break;
+    case hash_name("top_amount"):
+      if (is_eq(p, "top_amount"))
         return MAKE_FUNCTOR(report_t::fn_top_amount);
-      else if (is_eq(p, "to_boolean"))
+      break;
+    case hash_name("to_boolean"):
+      if (is_eq(p, "to_boolean"))
         return MAKE_FUNCTOR(report_t::fn_to_boolean);
-      else if (is_eq(p, "to_int"))
+      break;
+    case hash_name("to_int"):
+      if (is_eq(p, "to_int"))
         return MAKE_FUNCTOR(report_t::fn_to_int);
-      else if (is_eq(p, "to_datetime"))
+      break;
+    case hash_name("to_datetime"):
+      if (is_eq(p, "to_datetime"))
         return MAKE_FUNCTOR(report_t::fn_to_datetime);
-      else if (is_eq(p, "to_date"))
+      break;
+    case hash_name("to_date"):
+      if (is_eq(p, "to_date"))
         return MAKE_FUNCTOR(report_t::fn_to_date);
-      else if (is_eq(p, "to_amount"))
+      break;
+    case hash_name("to_amount"):
+      if (is_eq(p, "to_amount"))
         return MAKE_FUNCTOR(report_t::fn_to_amount);
-      else if (is_eq(p, "to_balance"))
+      break;
+    case hash_name("to_balance"):
+      if (is_eq(p, "to_balance"))
         return MAKE_FUNCTOR(report_t::fn_to_balance);
-      else if (is_eq(p, "to_string"))
+      break;
+    case hash_name("to_string"):
+      if (is_eq(p, "to_string"))
         return MAKE_FUNCTOR(report_t::fn_to_string);
-      else if (is_eq(p, "to_mask"))
+      break;
+    case hash_name("to_mask"):
+      if (is_eq(p, "to_mask"))
         return MAKE_FUNCTOR(report_t::fn_to_mask);
-      else if (is_eq(p, "to_sequence"))
+      break;
+    case hash_name("to_sequence"):
+      if (is_eq(p, "to_sequence"))
         return MAKE_FUNCTOR(report_t::fn_to_sequence);
       break;
 
-    case 'T':
+    case hash_name("T"):
       if (is_eq(p, "T"))
         return MAKE_FUNCTOR(report_t::fn_display_total);
       break;
 
-    case 'u':
+    case hash_name("underline"):
       if (is_eq(p, "underline"))
         return WRAP_FUNCTOR(fn_underline);
-      else if (is_eq(p, "unround"))
+      break;
+    case hash_name("unround"):
+      if (is_eq(p, "unround"))
         return MAKE_FUNCTOR(report_t::fn_unround);
-      else if (is_eq(p, "unrounded"))
+      break;
+    case hash_name("unrounded"):
+      if (is_eq(p, "unrounded"))
         return MAKE_FUNCTOR(report_t::fn_unrounded);
       break;
 
-    case 'v':
+    case hash_name("value_date"):
       if (is_eq(p, "value_date"))
         return MAKE_FUNCTOR(report_t::fn_now);
       break;
 
-    case 'w':
+    case hash_name("white"):
       if (is_eq(p, "white"))
         return WRAP_FUNCTOR(fn_white);
       break;
 
-    case 'y':
+    case hash_name("yellow"):
       if (is_eq(p, "yellow"))
         return WRAP_FUNCTOR(fn_yellow);
       break;
@@ -1609,18 +1939,22 @@ expr_t::ptr_op_t report_t::lookup(const symbol_t::kind_t kind,
         lexical_cast<std::size_t>(HANDLER(prepend_width_).str()) : 0))
 
   case symbol_t::COMMAND:
-    switch (*p) {
-    case 'a':
+    switch (hash_name(p)) {
+    case hash_name("accounts"):
       if (is_eq(p, "accounts")) {
         return POSTS_REPORTER(new report_accounts(*this));
       }
       break;
 
-    case 'b':
+    case hash_name("b"):
+    case hash_name("bal"):
+    case hash_name("balance"):
       if (*(p + 1) == '\0' || is_eq(p, "bal") || is_eq(p, "balance")) {
         return FORMATTED_ACCOUNTS_REPORTER(balance_format_);
       }
-      else if (is_eq(p, "budget")) {
+      break;
+    case hash_name("budget"):
+      if (is_eq(p, "budget")) {
         HANDLER(amount_).on(string("#budget"), "(amount, 0)");
 
         budget_flags |= BUDGET_WRAP_VALUES;
@@ -1631,97 +1965,135 @@ expr_t::ptr_op_t report_t::lookup(const symbol_t::kind_t kind,
       }
       break;
 
-    case 'c':
+    case hash_name("csv"):
       if (is_eq(p, "csv")) {
         return FORMATTED_POSTS_REPORTER(csv_format_);
       }
-      else if (is_eq(p, "cleared")) {
+      break;
+    case hash_name("cleared"):
+      if (is_eq(p, "cleared")) {
         HANDLER(amount_).on(string("#cleared"),
                             "(amount, cleared ? amount : 0)");
         return FORMATTED_ACCOUNTS_REPORTER(cleared_format_);
       }
-      else if (is_eq(p, "convert")) {
+      break;
+    case hash_name("convert"):
+      if (is_eq(p, "convert")) {
         return WRAP_FUNCTOR(convert_command);
       }
-      else if (is_eq(p, "commodities")) {
+      break;
+    case hash_name("commodities"):
+      if (is_eq(p, "commodities")) {
         return POSTS_REPORTER(new report_commodities(*this));
       }
       break;
-    case 'd':
+
+    case hash_name("draft"):
       if (is_eq(p, "draft")) {
         return WRAP_FUNCTOR(xact_command);
       }
       break;
-    case 'e':
+
+    case hash_name("equity"):
       if (is_eq(p, "equity")) {
         HANDLER(generated).on("#equity");
         return POSTS_REPORTER(new print_xacts(*this));
       }
-      else if (is_eq(p, "entry")) {
+      break;
+    case hash_name("entry"):
+      if (is_eq(p, "entry")) {
         return WRAP_FUNCTOR(xact_command);
       }
-      else if (is_eq(p, "emacs")) {
+      break;
+    case hash_name("emacs"):
+      if (is_eq(p, "emacs")) {
         return POSTS_REPORTER(new format_emacs_posts(output_stream));
       }
-      else if (is_eq(p, "echo")) {
+      break;
+    case hash_name("echo"):
+      if (is_eq(p, "echo")) {
         return MAKE_FUNCTOR(report_t::echo_command);
       }
       break;
 
-    case 'l':
+    case hash_name("lisp"):
       if (is_eq(p, "lisp"))
         return POSTS_REPORTER(new format_emacs_posts(output_stream));
       break;
-    case 'o':
+
+    case hash_name("org"):
       if (is_eq(p, "org"))
         return POSTS_REPORTER(new posts_to_org_table
                             (*this, maybe_format(HANDLER(prepend_format_))));
       break;
 
-    case 'p':
+    case hash_name("p"):
+    case hash_name("print"):
       if (*(p + 1) == '\0' || is_eq(p, "print")) {
         return POSTS_REPORTER(new print_xacts(*this, HANDLED(raw)));
       }
-      else if (is_eq(p, "prices")) {
+      break;
+    case hash_name("prices"):
+      if (is_eq(p, "prices")) {
         return FORMATTED_COMMODITIES_REPORTER(prices_format_);
       }
-      else if (is_eq(p, "pricedb") || is_eq(p, "pricesdb")) {
+      break;
+    case hash_name("pricedb"):
+    case hash_name("pricesdb"):
+      if (is_eq(p, "pricedb") || is_eq(p, "pricesdb")) {
         return FORMATTED_COMMODITIES_REPORTER(pricedb_format_);
       }
-      else if (is_eq(p, "pricemap")) {
+      break;
+    case hash_name("pricemap"):
+      if (is_eq(p, "pricemap")) {
         return MAKE_FUNCTOR(report_t::pricemap_command);
       }
-      else if (is_eq(p, "payees")) {
+      break;
+    case hash_name("payees"):
+      if (is_eq(p, "payees")) {
         return POSTS_REPORTER(new report_payees(*this));
       }
       break;
 
-    case 'r':
+    case hash_name("r"):
+    case hash_name("reg"):
+    case hash_name("register"):
       if (*(p + 1) == '\0' || is_eq(p, "reg") || is_eq(p, "register")) {
         return FORMATTED_POSTS_REPORTER(register_format_);
       }
-      else if (is_eq(p, "reload")) {
+      break;
+    case hash_name("reload"):
+      if (is_eq(p, "reload")) {
         return MAKE_FUNCTOR(report_t::reload_command);
       }
       break;
 
-    case 's':
+    case hash_name("stats"):
+    case hash_name("stat"):
       if (is_eq(p, "stats") || is_eq(p, "stat"))
         return WRAP_FUNCTOR(report_statistics);
-      else if (is_eq(p, "source"))
+      break;
+    case hash_name("source"):
+      if (is_eq(p, "source"))
         return WRAP_FUNCTOR(source_command);
-      else if (is_eq(p, "select"))
+      break;
+    case hash_name("select"):
+      if (is_eq(p, "select"))
         return WRAP_FUNCTOR(select_command);
       break;
-    case 't':
+
+    case hash_name("tags"):
       if (is_eq(p, "tags")) {
         return POSTS_REPORTER(new report_tags(*this));
       }
       break;
-    case 'x':
+
+    case hash_name("xact"):
       if (is_eq(p, "xact"))
         return WRAP_FUNCTOR(xact_command);
-      else if (is_eq(p, "xml"))
+      break;
+    case hash_name("xml"):
+      if (is_eq(p, "xml"))
         return POSTS_REPORTER(new format_ptree(*this,
                                                format_ptree::FORMAT_XML));
       break;
@@ -1729,41 +2101,52 @@ expr_t::ptr_op_t report_t::lookup(const symbol_t::kind_t kind,
     break;
 
   case symbol_t::PRECOMMAND:
-    switch (*p) {
-    case 'a':
+    switch (hash_name(p)) {
+    case hash_name("args"):
       if (is_eq(p, "args"))
         return WRAP_FUNCTOR(query_command);
       break;
-    case 'e':
+
+    case hash_name("eval"):
       if (is_eq(p, "eval"))
         return WRAP_FUNCTOR(eval_command);
-      else if (is_eq(p, "expr"))
+      break;
+    case hash_name("expr"):
+      if (is_eq(p, "expr"))
         return WRAP_FUNCTOR(parse_command);
       break;
-    case 'f':
+
+    case hash_name("format"):
       if (is_eq(p, "format"))
         return WRAP_FUNCTOR(format_command);
       break;
-    case 'g':
+
+    case hash_name("generate"):
       if (is_eq(p, "generate"))
         return POSTS_REPORTER_(&report_t::generate_report,
                                new print_xacts(*this));
       break;
-    case 'p':
+
+    case hash_name("parse"):
       if (is_eq(p, "parse"))
         return WRAP_FUNCTOR(parse_command);
-      else if (is_eq(p, "period"))
+      break;
+    case hash_name("period"):
+      if (is_eq(p, "period"))
         return WRAP_FUNCTOR(period_command);
       break;
-    case 'q':
+
+    case hash_name("query"):
       if (is_eq(p, "query"))
         return WRAP_FUNCTOR(query_command);
       break;
-    case 's':
+
+    case hash_name("script"):
       if (is_eq(p, "script"))
         return WRAP_FUNCTOR(source_command);
       break;
-    case 't':
+
+    case hash_name("template"):
       if (is_eq(p, "template"))
         return WRAP_FUNCTOR(template_command);
       break;
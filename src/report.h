@@ -145,6 +145,7 @@ public:
 
   void normalize_options(const string& verb);
   void normalize_period();
+  bool can_stream_journal(const string& verb);
   void parse_query_args(const value_t& args, const string& whence);
 
   void posts_report(post_handler_ptr handler);
@@ -281,6 +282,8 @@ public:
     HANDLER(equity).report(out);
     HANDLER(exact).report(out);
     HANDLER(exchange_).report(out);
+    HANDLER(explain_expr).report(out);
+    HANDLER(explain_plan).report(out);
     HANDLER(flat).report(out);
     HANDLER(force_color).report(out);
     HANDLER(force_pager).report(out);
@@ -341,8 +344,10 @@ public:
     HANDLER(sort_all_).report(out);
     HANDLER(sort_xacts_).report(out);
     HANDLER(start_of_week_).report(out);
+    HANDLER(stream).report(out);
     HANDLER(subtotal).report(out);
     HANDLER(tail_).report(out);
+    HANDLER(threads_).report(out);
     HANDLER(time_report).report(out);
     HANDLER(total_).report(out);
     HANDLER(total_data).report(out);
@@ -673,6 +678,10 @@ public:
       OTHER(market).on(whence);
     });
 
+  OPTION(report_t, explain_expr);
+
+  OPTION(report_t, explain_plan);
+
   OPTION(report_t, flat);
   OPTION(report_t, force_color);
   OPTION(report_t, force_pager);
@@ -971,8 +980,10 @@ public:
     });
 
   OPTION(report_t, start_of_week_);
+  OPTION(report_t, stream);
   OPTION(report_t, subtotal); // -s
   OPTION(report_t, tail_);
+  OPTION(report_t, threads_);
 
   OPTION_(report_t, time_report, DO() {
       OTHER(balance_format_)
@@ -107,6 +107,24 @@ public:
   virtual expr_t::ptr_op_t lookup(const symbol_t::kind_t kind,
                                   const string& name) = 0;
 
+  /**
+   * Returns the scope whose lookup() is consulted first when a name is
+   * looked up in this one.  Scopes which only pass lookups on to their
+   * parent answer with their parent's lookup scope.
+   */
+  virtual scope_t * lookup_scope() {
+    return this;
+  }
+  /**
+   * True if the definitions returned by lookup() depend only on the
+   * dynamic type of this scope, and never on its contents.  Such
+   * definitions may be remembered by the identifiers that asked for
+   * them (see lookup_ident in op.cc).
+   */
+  virtual bool lookup_by_type() const {
+    return false;
+  }
+
   virtual value_t::type_t type_context() const {
     return value_t::VOID;
   }
@@ -196,25 +214,83 @@ public:
       return def;
     return child_scope_t::lookup(kind, name);
   }
+
+  virtual scope_t * lookup_scope() {
+    return grandchild.lookup_scope();
+  }
+};
+
+/**
+ * How a scope relates to the type T being sought by search_scope.  The
+ * answer is the same for every scope of a given dynamic type, so it is
+ * worked out with dynamic_cast only the first time that type is seen.
+ */
+enum scope_relation_t {
+  SCOPE_SOUGHT,
+  SCOPE_BIND,
+  SCOPE_CHILD,
+  SCOPE_UNRELATED
 };
 
+template <typename T>
+scope_relation_t scope_relation(scope_t * ptr)
+{
+#if !defined(THREADSAFE)
+  static const std::size_t max_types = 16;
+
+  static const std::type_info * types[max_types];
+  static scope_relation_t       relations[max_types];
+  static std::size_t            count = 0;
+
+  const std::type_info * type = &typeid(*ptr);
+  for (std::size_t i = 0; i < count; i++)
+    if (types[i] == type)
+      return relations[i];
+#endif
+
+  scope_relation_t relation;
+  if (dynamic_cast<T *>(ptr))
+    relation = SCOPE_SOUGHT;
+  else if (dynamic_cast<bind_scope_t *>(ptr))
+    relation = SCOPE_BIND;
+  else if (dynamic_cast<child_scope_t *>(ptr))
+    relation = SCOPE_CHILD;
+  else
+    relation = SCOPE_UNRELATED;
+
+#if !defined(THREADSAFE)
+  if (count < max_types) {
+    types[count]     = type;
+    relations[count] = relation;
+    count++;
+  }
+#endif
+  return relation;
+}
+
 template <typename T>
 T * search_scope(scope_t * ptr, bool prefer_direct_parents = false)
 {
   DEBUG("scope.search", "Searching scope " << ptr->description());
 
-  if (T * sought = dynamic_cast<T *>(ptr))
-    return sought;
+  switch (scope_relation<T>(ptr)) {
+  case SCOPE_SOUGHT:
+    return static_cast<T *>(ptr);
 
-  if (bind_scope_t * scope = dynamic_cast<bind_scope_t *>(ptr)) {
+  case SCOPE_BIND: {
+    bind_scope_t * scope = static_cast<bind_scope_t *>(ptr);
     if (T * sought = search_scope<T>(prefer_direct_parents ?
                                      scope->parent : &scope->grandchild))
       return sought;
     return search_scope<T>(prefer_direct_parents ?
                            &scope->grandchild : scope->parent);
   }
-  else if (child_scope_t * child_scope = dynamic_cast<child_scope_t *>(ptr)) {
-    return search_scope<T>(child_scope->parent);
+
+  case SCOPE_CHILD:
+    return search_scope<T>(static_cast<child_scope_t *>(ptr)->parent);
+
+  case SCOPE_UNRELATED:
+    break;
   }
   return NULL;
 }
@@ -296,6 +372,10 @@ public:
     return parent->description();
   }
 
+  virtual scope_t * lookup_scope() {
+    return parent->lookup_scope();
+  }
+
   virtual value_t::type_t type_context() const {
     return value_type_context;
   }
@@ -37,6 +37,7 @@
 #include "journal.h"
 #include "iterators.h"
 #include "filters.h"
+#include "cache.h"
 
 namespace ledger {
 
@@ -128,6 +129,43 @@ std::size_t session_t::read_data(const string& master_account)
   if (HANDLED(value_expr_))
     journal->value_expr = HANDLER(value_expr_).str();
 
+  // A journal cache is only consulted when every input is a file, and not
+  // under --strict or --pedantic, whose diagnostics require a real parse.
+  optional<path> cache_path;
+  string         cache_signature;
+  if (HANDLED(cache_) &&
+      journal->checking_style != journal_t::CHECK_WARNING &&
+      journal->checking_style != journal_t::CHECK_ERROR &&
+      HANDLER(file_).data_files.count("-") == 0 &&
+      HANDLER(file_).data_files.count("/dev/stdin") == 0) {
+    cache_path = resolve_path(HANDLER(cache_).str());
+
+    // The signature covers everything besides the files themselves which
+    // influences how they are parsed.
+    std::ostringstream sig;
+    sig << master_account << '\n'
+        << (price_db_path && exists(*price_db_path) ?
+            price_db_path->string() : string()) << '\n';
+    foreach (const path& pathname, HANDLER(file_).data_files)
+      sig << pathname.string() << '\n';
+    sig << journal->day_break << journal->recursive_aliases
+        << journal->no_aliases << journal->force_checking
+        << journal->check_payees << journal->checking_style
+        << commodity_t::decimal_comma_by_default
+        << commodity_t::time_colon_by_default << '\n'
+        << (HANDLED(input_date_format_) ?
+            HANDLER(input_date_format_).str() : string()) << '\n'
+        << CURRENT_DATE().year();
+    cache_signature = sig.str();
+
+    if (read_journal_cache(*cache_path, *journal, cache_signature)) {
+      if (populated_data_files)
+        HANDLER(file_).data_files.clear();
+      journal->was_loaded = true;
+      return journal->xacts.size();
+    }
+  }
+
   if (price_db_path) {
     if (exists(*price_db_path)) {
       parsing_context.push(*price_db_path);
@@ -179,11 +217,16 @@ std::size_t session_t::read_data(const string& master_account)
 
   DEBUG("ledger.read", "xact_count [" << xact_count
         << "] == journal->xacts.size() [" << journal->xacts.size() << "]");
-  assert(xact_count == journal->xacts.size());
+  assert(journal->xact_streamer || xact_count == journal->xacts.size());
+
+  if (cache_path)
+    write_journal_cache(*cache_path, *journal, cache_signature);
 
   if (populated_data_files)
     HANDLER(file_).data_files.clear();
 
+  journal->was_loaded = true;
+
   VERIFY(journal->valid());
 
   return journal->xacts.size();
@@ -211,6 +254,94 @@ journal_t * session_t::read_journal_files()
   return journal.get();
 }
 
+bool session_t::read_appended_data()
+{
+  // Only the last journal file named may have changed, and then only by
+  // having text appended to it.  Everything read before it, including
+  // the files it includes and the price database, must be as it was.
+  if (journal->sources.empty() || HANDLER(file_).data_files.empty())
+    return false;
+
+  const journal_t::fileinfo_t last(journal->sources.back());
+  file_mapping_t mapping;
+  try {
+    if (! last.resumable || ! last.filename ||
+        ! filesystem::equivalent(*last.filename,
+                                 *HANDLER(file_).data_files.rbegin()))
+      return false;
+
+    foreach (const journal_t::fileinfo_t& info, journal->sources) {
+      if (&info == &journal->sources.back())
+        break;
+      if (info.from_stream || ! info.filename ||
+          file_size(*info.filename) != info.size ||
+          posix_time::from_time_t(last_write_time(*info.filename)) !=
+          info.modtime)
+        return false;
+    }
+
+    mapping = map_journal_file(*last.filename);
+  }
+  catch (const filesystem_error&) {
+    return false;
+  }
+
+  const std::size_t offset = static_cast<std::size_t>(last.offset);
+  if (! mapping || mapping->size() < offset ||
+      hash_file_bytes(mapping->const_data(), offset) != last.hash)
+    return false;
+
+  if (mapping->size() == offset)
+    return true;
+
+  // A line beginning with whitespace would continue whatever entry ended
+  // the text already read, which must then be parsed again.
+  const char first = mapping->const_data()[offset];
+  if (first == ' ' || first == '\t')
+    return false;
+
+  DEBUG("ledger.read", "Reading " << (mapping->size() - offset)
+        << " bytes appended to " << *last.filename);
+
+  account_t * acct = journal->master;
+  if (HANDLED(master_account_))
+    acct = journal->find_account(HANDLER(master_account_).str());
+
+  parsing_context.push(open_for_reading(*last.filename,
+                                        filesystem::current_path(), mapping));
+
+  parse_context_t& current(parsing_context.get_current());
+  current.map_pos     += offset;
+  current.linenum      = last.linenum;
+  current.sequence     = last.sequence;
+  current.content_hash = last.hash;
+  current.journal      = journal.get();
+  current.master       = acct;
+
+  journal->sources.pop_back();
+  try {
+    journal->read(parsing_context);
+  }
+  catch (...) {
+    parsing_context.pop();
+    throw;
+  }
+  parsing_context.pop();
+
+  return true;
+}
+
+journal_t * session_t::reload_journal_files()
+{
+  if (read_appended_data()) {
+    DEBUG("ledger.read", "Reloaded only appended journal data");
+    return journal.get();
+  }
+
+  close_journal_files();
+  return read_journal_files();
+}
+
 journal_t * session_t::read_journal(const path& pathname)
 {
   HANDLER(file_).data_files.clear();
@@ -317,7 +448,8 @@ option_t<session_t> * session_t::lookup_option(const char * p)
     OPT_CH(price_exp_);
     break;
   case 'c':
-    OPT(check_payees);
+    OPT(cache_);
+    else OPT(check_payees);
     break;
   case 'd':
     OPT(download); // -Q
@@ -94,6 +94,14 @@ public:
   journal_t * read_journal_files();
   void close_journal_files();
 
+  /**
+   * Parse only what has been appended to the last journal file since it
+   * was read, if nothing else has changed.  Returns false if the journal
+   * must instead be read again from scratch.
+   */
+  bool read_appended_data();
+  journal_t * reload_journal_files();
+
   journal_t * get_journal();
 
   value_t fn_account(call_scope_t& scope);
@@ -107,6 +115,7 @@ public:
 
   void report_options(std::ostream& out)
   {
+    HANDLER(cache_).report(out);
     HANDLER(check_payees).report(out);
     HANDLER(day_break).report(out);
     HANDLER(download).report(out);
@@ -135,6 +144,7 @@ public:
    * Option handlers
    */
 
+  OPTION(session_t, cache_);
   OPTION(session_t, check_payees);
   OPTION(session_t, day_break);
   OPTION(session_t, download); // -Q
@@ -69,6 +69,16 @@ namespace {
       : label(_label), value(rate) {}
   };
 
+  // True if the line from `p' to `end' begins with the directive `name'
+  bool is_directive(const char * p, const char * end, const char * name)
+  {
+    std::size_t len = std::strlen(name);
+    return (static_cast<std::size_t>(end - p) >= len &&
+            std::strncmp(p, name, len) == 0 &&
+            (p + len == end || std::isspace(static_cast<unsigned char>
+                                            (p[len]))));
+  }
+
   class instance_t : public noncopyable, public scope_t
   {
   public:
@@ -78,6 +88,8 @@ namespace {
     instance_t *             parent;
     std::list<application_t> apply_stack;
     bool                     no_assertions;
+    bool                     unterminated_block;
+    std::list<path>          preloaded;
 #if defined(TIMELOG_SUPPORT)
     time_log_t               timelog;
 #endif
@@ -88,7 +100,8 @@ namespace {
                const bool             _no_assertions = false)
       : context_stack(_context_stack), context(_context),
         in(*context.stream.get()), parent(_parent),
-        no_assertions(_no_assertions), timelog(context) {}
+        no_assertions(_no_assertions), unterminated_block(false),
+        timelog(context) {}
 
     virtual string description() {
       return _("textual parser");
@@ -123,15 +136,27 @@ namespace {
     void parse();
 
     std::streamsize read_line(char *& line);
+    std::streamsize read_mapped_line(char *& line);
+
+    bool at_eof() {
+      if (context.mapping)
+        return context.map_pos == context.map_end;
+      else
+        return ! in.good() || in.eof();
+    }
+    int peek_char() {
+      if (context.mapping)
+        return context.map_pos == context.map_end ? EOF : *context.map_pos;
+      else
+        return in.peek();
+    }
 
     bool peek_whitespace_line() {
-      return (in.good() && ! in.eof() &&
-              (in.peek() == ' ' || in.peek() == '\t'));
+      return (! at_eof() && (peek_char() == ' ' || peek_char() == '\t'));
     }
 #if HAVE_BOOST_PYTHON
     bool peek_blank_line() {
-      return (in.good() && ! in.eof() &&
-              (in.peek() == '\n' || in.peek() == '\r'));
+      return (! at_eof() && (peek_char() == '\n' || peek_char() == '\r'));
     }
 #endif
 
@@ -182,6 +207,8 @@ namespace {
     void price_conversion_directive(char * line);
     void nomarket_directive(char * line);
 
+    path find_included_files(const char * line, std::list<path>& files);
+    void preload_included_files();
     void include_directive(char * line);
     void option_directive(char * line);
     void comment_directive(char * line);
@@ -239,15 +266,32 @@ void instance_t::parse()
 
   TRACE_START(instance_parse, 1, "Done parsing file " << context.pathname);
 
-  if (! in.good() || in.eof())
+  if (at_eof())
     return;
 
-  context.linenum  = 0;
-  context.curr_pos = in.tellg();
+  // The line number is not reset here, since a caller resuming a file
+  // part way through presets it to the number of lines already read.
+  bool ends_in_newline = false;
+  if (context.mapping) {
+    context.curr_pos = context.map_pos - context.mapping->data();
+
+    // Lines are terminated in place as they are read, so the contents of
+    // a top-level file must be hashed first if it is to be resumed later.
+    if (! parent) {
+      context.content_hash =
+        hash_file_bytes(context.map_pos, static_cast<std::size_t>
+                        (context.map_end - context.map_pos),
+                        context.content_hash);
+      ends_in_newline = *(context.map_end - 1) == '\n';
+    }
+    preload_included_files();
+  } else {
+    context.curr_pos = in.tellg();
+  }
 
   bool error_flag = false;
 
-  while (in.good() && ! in.eof()) {
+  while (! at_eof()) {
     try {
       read_next_directive(error_flag);
     }
@@ -285,6 +329,20 @@ void instance_t::parse()
     }
   }
 
+  // Files named by include directives which were never reached, such as
+  // those after an error, need not be kept in memory any longer.
+  context_stack.drop_preloads(preloaded);
+
+  // Text later appended to this file can be parsed by itself only if
+  // nothing is left open at the end of what was read: no "apply" block,
+  // comment block or clock-in, and no partial last line.
+  context.resumable = (ends_in_newline && apply_stack.size() == 1 &&
+                       ! unterminated_block && context.errors == 0);
+#if defined(TIMELOG_SUPPORT)
+  if (! timelog.empty())
+    context.resumable = false;
+#endif
+
   if (apply_stack.front().value.type() == typeid(optional<datetime_t>))
     epoch = boost::get<optional<datetime_t> >(apply_stack.front().value);
 
@@ -297,17 +355,60 @@ void instance_t::parse()
   TRACE_STOP(instance_parse, 1);
 }
 
+std::streamsize instance_t::read_mapped_line(char *& line)
+{
+  char * beg = context.map_pos;
+  char * end = static_cast<char *>
+    (std::memchr(beg, '\n', static_cast<std::size_t>(context.map_end - beg)));
+
+  // The length returned mirrors std::istream::gcount after getline, in
+  // that it counts the newline if one was consumed.
+  std::streamsize len;
+  if (end) {
+    len = end - beg + 1;
+    context.map_pos = end + 1;
+  } else {
+    len = context.map_end - beg;
+    context.map_pos = context.map_end;
+  }
+
+  if (len >= static_cast<std::streamsize>(parse_context_t::MAX_LINE)) {
+    context.linenum++;
+    context.curr_pos += len;
+    throw_(parse_error, _f("Line exceeds the maximum length of %1% bytes")
+           % (parse_context_t::MAX_LINE - 1));
+  }
+
+  if (end) {
+    // The mapping is private, so the line can be terminated in place
+    *end = '\0';
+    line = beg;
+  } else {
+    // The last line has no newline, and the mapping may end right after
+    // it, so copy it out to make room for the terminator
+    std::memcpy(context.linebuf, beg, static_cast<std::size_t>(len));
+    context.linebuf[len] = '\0';
+    line = context.linebuf;
+  }
+  return len;
+}
+
 std::streamsize instance_t::read_line(char *& line)
 {
-  assert(in.good());
-  assert(! in.eof());           // no one should call us in that case
+  assert(! at_eof());           // no one should call us in that case
 
   context.line_beg_pos = context.curr_pos;
 
   check_for_signal();
 
-  in.getline(context.linebuf, parse_context_t::MAX_LINE);
-  std::streamsize len = in.gcount();
+  std::streamsize len;
+  if (context.mapping) {
+    len = read_mapped_line(line);
+  } else {
+    in.getline(context.linebuf, parse_context_t::MAX_LINE);
+    len  = in.gcount();
+    line = context.linebuf;
+  }
 
   if (len > 0) {
     context.linenum++;
@@ -315,11 +416,9 @@ std::streamsize instance_t::read_line(char *& line)
     context.curr_pos  = context.line_beg_pos;
     context.curr_pos += len;
 
-    if (context.linenum == 0 && utf8::is_bom(context.linebuf)) {
-      line = &context.linebuf[3];
-      len -= 3;
-    } else {
-      line = context.linebuf;
+    if (context.linenum == 0 && utf8::is_bom(line)) {
+      line += 3;
+      len  -= 3;
     }
 
     --len;
@@ -440,7 +539,8 @@ void instance_t::clock_in_directive(char * line, bool capitalized)
 {
   string datetime(line, 2, 19);
 
-  char * p   = skip_ws(line + 22);
+  // The account is optional, so don't read past the end of the line
+  char * p   = skip_ws(line + std::min<std::size_t>(std::strlen(line), 22));
   char * n   = next_element(p, true);
   char * end = n ? next_element(n, true) : NULL;
 
@@ -469,7 +569,7 @@ void instance_t::clock_out_directive(char * line, bool capitalized)
 {
   string datetime(line, 2, 19);
 
-  char * p = skip_ws(line + 22);
+  char * p = skip_ws(line + std::min<std::size_t>(std::strlen(line), 22));
   char * n = next_element(p, true);
   char * end = n ? next_element(n, true) : NULL;
 
@@ -539,6 +639,8 @@ void instance_t::nomarket_directive(char * line)
 
 void instance_t::option_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   char * p = next_element(line);
   if (! p) {
     p = std::strchr(line, '=');
@@ -546,6 +648,13 @@ void instance_t::option_directive(char * line)
       *p++ = '\0';
   }
 
+  // By the time a streamed journal is read, the report it feeds has
+  // already been set up from the options given.
+  if (context.journal->xact_streamer)
+    throw_(option_error,
+           _f("Option --%1% cannot be set in a journal read with --stream")
+           % (line + 2));
+
   if (! process_option(context.pathname.string(), line + 2, *context.scope,
                        p, line))
     throw_(option_error, _f("Illegal option --%1%") % (line + 2));
@@ -715,7 +824,8 @@ void instance_t::xact_directive(char * line, std::streamsize len)
   TRACE_STOP(xacts, 1);
 }
 
-void instance_t::include_directive(char * line)
+path instance_t::find_included_files(const char *     line,
+                                     std::list<path>& files)
 {
   path filename;
 
@@ -751,7 +861,6 @@ void instance_t::include_directive(char * line)
   glob.assign_glob('^' + filename.leaf() + '$');
 #endif // BOOST_VERSION >= 103700
 
-  bool files_found = false;
   if (exists(parent_path)) {
     filesystem::directory_iterator end;
     for (filesystem::directory_iterator iter(parent_path);
@@ -772,53 +881,117 @@ void instance_t::include_directive(char * line)
 #else // BOOST_VERSION >= 103700
         string base = (*iter).leaf();
 #endif // BOOST_VERSION >= 103700
-        if (glob.match(base)) {
-          journal_t *  journal  = context.journal;
-          account_t *  master   = top_account();
-          scope_t *    scope    = context.scope;
-          std::size_t& errors   = context.errors;
-          std::size_t& count    = context.count;
-          std::size_t& sequence = context.sequence;
-
-          DEBUG("textual.include", "Including: " << *iter);
-          DEBUG("textual.include", "Master account: " << master->fullname());
-
-          context_stack.push(*iter);
-
-          context_stack.get_current().journal = journal;
-          context_stack.get_current().master  = master;
-          context_stack.get_current().scope   = scope;
-          try {
-            instance_t instance(context_stack, context_stack.get_current(),
-                                this, no_assertions);
-            instance.apply_stack.push_front(application_t("account", master));
-            instance.parse();
-          }
-          catch (...) {
-            errors   += context_stack.get_current().errors;
-            count    += context_stack.get_current().count;
-            sequence += context_stack.get_current().sequence;
+        if (glob.match(base))
+          files.push_back(*iter);
+      }
+    }
+  }
+  return filename;
+}
 
-            context_stack.pop();
-            throw;
-          }
+void instance_t::preload_included_files()
+{
+  // Scan ahead for include directives, so that the files they name can
+  // be read in by worker threads while this file is being parsed.  The
+  // bodies of comment and test blocks are never parsed, so any include
+  // directives within them are passed over.
+  bool in_block = false;
+  for (const char * p = context.map_pos; p < context.map_end; ) {
+    const char * end = static_cast<const char *>
+      (std::memchr(p, '\n', static_cast<std::size_t>(context.map_end - p)));
+    if (! end)
+      end = context.map_end;
+
+    const char * q = p;
+    if (*q == '!' || *q == '@')
+      q++;
+
+    if (in_block) {
+      // The same test comment_directive() makes for the end of the block
+      if ((end - p >= 11 && std::strncmp(p, "end comment", 11) == 0) ||
+          (end - p >= 8 && std::strncmp(p, "end test", 8) == 0))
+        in_block = false;
+    }
+    else if (is_directive(q, end, "comment") || is_directive(q, end, "test")) {
+      in_block = true;
+    }
+    else if (end - q > 8 && std::strncmp(q, "include", 7) == 0 &&
+             (q[7] == ' ' || q[7] == '\t')) {
+      string arg(q + 8, end);
+      trim(arg);
+      if (! arg.empty()) {
+        try {
+          std::list<path> files;
+          find_included_files(arg.c_str(), files);
+          foreach (const path& pathname, files)
+            if (context_stack.preload(pathname))
+              preloaded.push_back(pathname);
+        }
+        catch (const std::exception&) {
+          // Any error will be reported when the directive is parsed
+        }
+      }
+    }
+    p = end + 1;
+  }
+}
 
-          errors   += context_stack.get_current().errors;
-          count    += context_stack.get_current().count;
-          sequence += context_stack.get_current().sequence;
+void instance_t::include_directive(char * line)
+{
+  std::list<path> files;
+  path filename = find_included_files(line, files);
 
-          context_stack.pop();
+  // Read in all files matched by a glob concurrently
+  foreach (const path& pathname, files)
+    context_stack.preload(pathname);
 
-          files_found = true;
-        }
-      }
+  bool files_found = false;
+  foreach (const path& pathname, files) {
+    journal_t *  journal  = context.journal;
+    account_t *  master   = top_account();
+    scope_t *    scope    = context.scope;
+    std::size_t& errors   = context.errors;
+    std::size_t& count    = context.count;
+    std::size_t& sequence = context.sequence;
+
+    DEBUG("textual.include", "Including: " << pathname);
+    DEBUG("textual.include", "Master account: " << master->fullname());
+
+    context_stack.push(pathname);
+
+    context_stack.get_current().journal = journal;
+    context_stack.get_current().master  = master;
+    context_stack.get_current().scope   = scope;
+    try {
+      instance_t instance(context_stack, context_stack.get_current(),
+                          this, no_assertions);
+      instance.apply_stack.push_front(application_t("account", master));
+      instance.parse();
+    }
+    catch (...) {
+      errors   += context_stack.get_current().errors;
+      count    += context_stack.get_current().count;
+      sequence += context_stack.get_current().sequence;
+
+      context_stack.pop();
+      throw;
     }
+
+    errors   += context_stack.get_current().errors;
+    count    += context_stack.get_current().count;
+    sequence += context_stack.get_current().sequence;
+
+    if (is_regular_file(pathname))
+      journal->sources.push_back(journal_t::fileinfo_t(pathname));
+
+    context_stack.pop();
+
+    files_found = true;
   }
 
   if (! files_found)
     throw_(std::runtime_error,
            _f("File to include was not found: %1%") % filename);
-
 }
 
 void instance_t::apply_directive(char * line)
@@ -981,7 +1154,7 @@ void instance_t::account_directive(char * line)
     context.journal->auto_xacts.push_back(ae.get());
 
     ae->journal       = context.journal;
-    ae->pos->end_pos  = in.tellg();
+    ae->pos->end_pos  = context.curr_pos;
     ae->pos->end_line = context.linenum;
 
     ae.release();
@@ -1168,12 +1341,14 @@ void instance_t::tag_directive(char * line)
 
 void instance_t::eval_directive(char * line)
 {
+  context.journal->cacheable = false;
   expr_t expr(line);
   expr.calc(*context.scope);
 }
 
 void instance_t::assert_directive(char * line)
 {
+  context.journal->cacheable = false;
   expr_t expr(line);
   if (! expr.calc(*context.scope).to_boolean())
     throw_(parse_error, _f("Assertion failed: %1%") % line);
@@ -1181,6 +1356,7 @@ void instance_t::assert_directive(char * line)
 
 void instance_t::check_directive(char * line)
 {
+  context.journal->cacheable = false;
   expr_t expr(line);
   if (! expr.calc(*context.scope).to_boolean())
     context.warning(_f("Check failed: %1%") % line);
@@ -1188,24 +1364,28 @@ void instance_t::check_directive(char * line)
 
 void instance_t::value_directive(char * line)
 {
+  context.journal->cacheable = false;
   context.journal->value_expr = expr_t(line);
 }
 
 void instance_t::comment_directive(char * line)
 {
-  while (in.good() && ! in.eof()) {
+  while (! at_eof()) {
     if (read_line(line) > 0) {
       std::string buf(line);
       if (starts_with(buf, "end comment") || starts_with(buf, "end test"))
-        break;
+        return;
     }
   }
+  unterminated_block = true;
 }
 
 #if HAVE_BOOST_PYTHON
 
 void instance_t::import_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   string module_name(line);
   trim(module_name);
   python_session->import_option(module_name);
@@ -1213,6 +1393,8 @@ void instance_t::import_directive(char * line)
 
 void instance_t::python_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   std::ostringstream script;
 
   if (line)
@@ -1396,6 +1578,7 @@ bool instance_t::general_directive(char * line)
   }
 
   if (expr_t::ptr_op_t op = lookup(symbol_t::DIRECTIVE, p)) {
+    context.journal->cacheable = false;
     call_scope_t args(*this);
     args.push_back(string_value(p));
     op->as_function()(args);
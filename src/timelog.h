@@ -103,6 +103,10 @@ public:
   void clock_in(time_xact_t event);
   std::size_t clock_out(time_xact_t event);
 
+  bool empty() const {
+    return time_xacts.empty();
+  }
+
   void close();
 };
 
@@ -500,6 +500,21 @@ path resolve_path(const path& pathname);
 extern "C" char * realpath(const char *, char resolved_path[]);
 #endif
 
+/**
+ * Hash a symbol name (FNV-1a), for use as the case labels of scope lookup
+ * tables.  A dash hashes as an underscore and a trailing underscore is
+ * ignored, so that every spelling is_eq() accepts lands in the same case.
+ * Since the compiler rejects duplicate labels, each such switch is a
+ * perfect hash over its names, and one string compare confirms a hit.
+ */
+inline constexpr uint_least64_t
+hash_name(const char * p, const uint_least64_t h = 14695981039346656037ULL)
+{
+  return (! *p || ((*p == '_' || *p == '-') && ! *(p + 1))) ? h :
+    hash_name(p + 1, (h ^ static_cast<unsigned char>(*p == '-' ? '_' : *p)) *
+              1099511628211ULL);
+}
+
 inline const string& either_or(const string& first,
                                const string& second) {
   return first.empty() ? second : first;
@@ -40,9 +40,6 @@
 
 namespace ledger {
 
-intrusive_ptr<value_t::storage_t> value_t::true_value;
-intrusive_ptr<value_t::storage_t> value_t::false_value;
-
 value_t::storage_t& value_t::storage_t::operator=(const value_t::storage_t& rhs)
 {
   type = rhs.type;
@@ -65,19 +62,10 @@ value_t::storage_t& value_t::storage_t::operator=(const value_t::storage_t& rhs)
 
 void value_t::initialize()
 {
-  true_value        = new storage_t;
-  true_value->type  = BOOLEAN;
-  true_value->data  = true;
-
-  false_value       = new storage_t;
-  false_value->type = BOOLEAN;
-  false_value->data = false;
 }
 
 void value_t::shutdown()
 {
-  true_value  = intrusive_ptr<storage_t>();
-  false_value = intrusive_ptr<storage_t>();
 }
 
 value_t::operator bool() const
@@ -128,13 +116,40 @@ value_t::operator bool() const
 
 void value_t::set_type(type_t new_type)
 {
+  _destroy_inline();
+
   if (new_type == VOID) {
 #if BOOST_VERSION >= 103700
     storage.reset();
 #else
     storage = intrusive_ptr<storage_t>();
 #endif
-  } else {
+  }
+  else if (is_inline_type(new_type)) {
+    // Callers always assign a value immediately afterward; make sure
+    // that what is left here is at least well-formed.
+    switch (new_type) {
+    case AMOUNT:
+      new (&inline_data) amount_t();
+      break;
+    case DATETIME:
+      new (&inline_data) datetime_t();
+      break;
+    case DATE:
+      new (&inline_data) date_t();
+      break;
+    default:
+      std::memset(&inline_data, 0, sizeof(inline_data));
+      break;
+    }
+    inline_type = new_type;
+#if BOOST_VERSION >= 103700
+    storage.reset();
+#else
+    storage = intrusive_ptr<storage_t>();
+#endif
+  }
+  else {
     if (! storage || storage->refc > 1)
       storage = new storage_t;
     else
@@ -118,24 +118,19 @@ public:
 
     /**
      * The `data' member holds the actual bytes relating to whatever
-     * has been stuffed into this storage object.  There is a set of
-     * asserts in value.cc to guarantee that the sizeof expression
-     * used here is indeed at least as big as the largest object that
-     * will ever be copied into `data'.
+     * has been stuffed into this storage object.  Only the types which
+     * are too large or too costly to copy are kept here; the others
+     * are held inline by value_t itself (see `inline_data' below).
+     * The bool is only used as the empty state.
      *
      * The `type' member holds the value_t::type_t value representing
      * the type of the object stored.
      */
-    variant<bool,               // BOOLEAN
-            datetime_t,         // DATETIME
-            date_t,             // DATE
-            long,               // INTEGER
-            amount_t,           // AMOUNT
+    variant<bool,               // none
             balance_t *,        // BALANCE
             string,             // STRING
             mask_t,             // MASK
             sequence_t *,       // SEQUENCE
-            scope_t *,          // SCOPE
             boost::any          // ANY
             > data;
 
@@ -231,11 +226,64 @@ public:
 
 private:
   /**
-   * The actual data for each value_t is kept in reference counted storage.
-   * Data is modified using a copy-on-write policy.
+   * Balances, strings, masks, sequences and arbitrary objects are kept
+   * in reference counted storage, and modified using a copy-on-write
+   * policy.
    */
   intrusive_ptr<storage_t> storage;
 
+  /**
+   * Booleans, dates, integers, amounts and scope pointers are held
+   * directly in `inline_data', so that the many temporaries created
+   * while evaluating expressions never touch the heap.  `inline_type'
+   * is VOID whenever `storage' is in use.
+   */
+  static const std::size_t inline_size =
+    sizeof(amount_t) > sizeof(datetime_t) ? sizeof(amount_t) : sizeof(datetime_t);
+  static const std::size_t inline_align =
+    alignof(amount_t) > alignof(datetime_t) ? alignof(amount_t) : alignof(datetime_t);
+
+  type_t inline_type;
+  std::aligned_storage<inline_size, inline_align>::type inline_data;
+
+  static bool is_inline_type(type_t the_type) {
+    return (the_type == BOOLEAN || the_type == DATETIME ||
+            the_type == DATE    || the_type == INTEGER  ||
+            the_type == AMOUNT  || the_type == SCOPE);
+  }
+
+  template <typename T>
+  T& inline_as() {
+    return *reinterpret_cast<T *>(&inline_data);
+  }
+  template <typename T>
+  const T& inline_as() const {
+    return *reinterpret_cast<const T *>(&inline_data);
+  }
+
+  void _destroy_inline() {
+    // Amounts are the only inline type with a destructor.
+    if (inline_type == AMOUNT)
+      inline_as<amount_t>().~amount_t();
+    inline_type = VOID;
+  }
+
+  template <typename T>
+  void _set_inline(type_t new_type, const T& val) {
+    _destroy_inline();
+    new (&inline_data) T(val);
+    inline_type = new_type;
+    storage.reset();
+  }
+
+  void _copy_inline(const value_t& val) {
+    if (val.inline_type == AMOUNT)
+      new (&inline_data) amount_t(val.inline_as<amount_t>());
+    else if (val.inline_type != VOID)
+      std::memcpy(&inline_data, &val.inline_data, sizeof(inline_data));
+    inline_type = val.inline_type;
+  }
+
   /**
    * Make a private copy of the current value (if necessary) so it can
    * subsequently be modified.
@@ -245,14 +293,6 @@ private:
       storage = new storage_t(*storage.get());
   }
 
-  /**
-   * Because boolean "true" and "false" are so common, a pair of static
-   * references are kept to prevent the creation of throwaway storage_t
-   * objects just to represent these two common values.
-   */
-  static intrusive_ptr<storage_t> true_value;
-  static intrusive_ptr<storage_t> false_value;
-
 public:
   static void initialize();
   static void shutdown();
@@ -271,50 +311,50 @@ public:
    * true) is required to represent the literal string "$100", and not
    * the amount "one hundred dollars".
    */
-  value_t() {
+  value_t() : inline_type(VOID) {
     TRACE_CTOR(value_t, "");
   }
 
-  value_t(const bool val) {
+  value_t(const bool val) : inline_type(VOID) {
     set_boolean(val);
     TRACE_CTOR(value_t, "const bool");
   }
 
-  value_t(const datetime_t& val) {
+  value_t(const datetime_t& val) : inline_type(VOID) {
     set_datetime(val);
     TRACE_CTOR(value_t, "const datetime_t&");
   }
-  value_t(const date_t& val) {
+  value_t(const date_t& val) : inline_type(VOID) {
     set_date(val);
     TRACE_CTOR(value_t, "const date_t&");
   }
 
-  value_t(const long val) {
+  value_t(const long val) : inline_type(VOID) {
     set_long(val);
     TRACE_CTOR(value_t, "const long");
   }
-  value_t(const unsigned long val) {
+  value_t(const unsigned long val) : inline_type(VOID) {
     set_amount(val);
     TRACE_CTOR(value_t, "const unsigned long");
   }
-  value_t(const double val) {
+  value_t(const double val) : inline_type(VOID) {
     set_amount(val);
     TRACE_CTOR(value_t, "const double");
   }
-  value_t(const amount_t& val) {
+  value_t(const amount_t& val) : inline_type(VOID) {
     set_amount(val);
     TRACE_CTOR(value_t, "const amount_t&");
   }
-  value_t(const balance_t& val) {
+  value_t(const balance_t& val) : inline_type(VOID) {
     set_balance(val);
     TRACE_CTOR(value_t, "const balance_t&");
   }
-  value_t(const mask_t& val) {
+  value_t(const mask_t& val) : inline_type(VOID) {
     set_mask(val);
     TRACE_CTOR(value_t, "const mask_t&");
   }
 
-  explicit value_t(const string& val, bool literal = false) {
+  explicit value_t(const string& val, bool literal = false) : inline_type(VOID) {
     if (literal)
       set_string(val);
     else
@@ -322,7 +362,7 @@ public:
 
     TRACE_CTOR(value_t, "const string&, bool");
   }
-  explicit value_t(const char * val, bool literal = false) {
+  explicit value_t(const char * val, bool literal = false) : inline_type(VOID) {
     if (literal)
       set_string(val);
     else
@@ -331,44 +371,55 @@ public:
     TRACE_CTOR(value_t, "const char *");
   }
 
-  value_t(const sequence_t& val) {
+  value_t(const sequence_t& val) : inline_type(VOID) {
     set_sequence(val);
     TRACE_CTOR(value_t, "const sequence_t&");
   }
 
-  explicit value_t(scope_t * item) {
+  explicit value_t(scope_t * item) : inline_type(VOID) {
     set_scope(item);
     TRACE_CTOR(value_t, "scope_t *");
   }
 #if 0
   template <typename T>
-  explicit value_t(T& item) {
+  explicit value_t(T& item) : inline_type(VOID) {
     set_any(item);
     TRACE_CTOR(value_t, "T&");
   }
 #endif
 
   /**
-   * Destructor.  This does not do anything, because the intrusive_ptr
-   * that refers to our storage object will decrease its reference
-   * count itself upon destruction.
+   * Destructor.  Only an inline amount needs to be destroyed here; the
+   * intrusive_ptr that refers to our storage object will decrease its
+   * reference count itself upon destruction.
    */
   ~value_t() {
     TRACE_DTOR(value_t);
+    _destroy_inline();
   }
 
   /**
    * Assignment and copy operators.  Values are cheaply copied by
-   * simply creating another reference to the other value's storage
-   * object.  A true copy is only ever made prior to modification.
+   * copying their inline data, or by creating another reference to the
+   * other value's storage object.  A true copy of storage is only ever
+   * made prior to modification.
    */
-  value_t(const value_t& val) {
+  value_t(const value_t& val) : inline_type(VOID) {
     *this = val;
     TRACE_CTOR(value_t, "copy");
   }
   value_t& operator=(const value_t& val) {
-    if (! (this == &val || storage == val.storage))
-      storage = val.storage;
+    if (this == &val)
+      return *this;
+
+    if (inline_type == AMOUNT && val.inline_type == AMOUNT) {
+      inline_as<amount_t>() = val.inline_as<amount_t>();
+    } else {
+      _destroy_inline();
+      _copy_inline(val);
+      if (storage != val.storage)
+        storage = val.storage;
+    }
     return *this;
   }
 
@@ -498,7 +549,7 @@ public:
   bool is_realzero() const;
   bool is_zero() const;
   bool is_null() const {
-    if (! storage) {
+    if (! storage && inline_type == VOID) {
       VERIFY(is_type(VOID));
       return true;
     } else {
@@ -508,7 +559,7 @@ public:
   }
 
   type_t type() const {
-    return storage ? storage->type : VOID;
+    return storage ? storage->type : inline_type;
   }
   bool is_type(type_t _type) const {
     return type() == _type;
@@ -552,16 +603,14 @@ public:
   }
   bool& as_boolean_lval() {
     VERIFY(is_boolean());
-    _dup();
-    return boost::get<bool>(storage->data);
+    return inline_as<bool>();
   }
   const bool& as_boolean() const {
     VERIFY(is_boolean());
-    return boost::get<bool>(storage->data);
+    return inline_as<bool>();
   }
   void set_boolean(const bool val) {
-    set_type(BOOLEAN);
-    storage = val ? true_value : false_value;
+    _set_inline(BOOLEAN, val);
   }
 
   bool is_datetime() const {
@@ -569,16 +618,14 @@ public:
   }
   datetime_t& as_datetime_lval() {
     VERIFY(is_datetime());
-    _dup();
-    return boost::get<datetime_t>(storage->data);
+    return inline_as<datetime_t>();
   }
   const datetime_t& as_datetime() const {
     VERIFY(is_datetime());
-    return boost::get<datetime_t>(storage->data);
+    return inline_as<datetime_t>();
   }
   void set_datetime(const datetime_t& val) {
-    set_type(DATETIME);
-    storage->data = val;
+    _set_inline(DATETIME, val);
   }
 
   bool is_date() const {
@@ -586,16 +633,14 @@ public:
   }
   date_t& as_date_lval() {
     VERIFY(is_date());
-    _dup();
-    return boost::get<date_t>(storage->data);
+    return inline_as<date_t>();
   }
   const date_t& as_date() const {
     VERIFY(is_date());
-    return boost::get<date_t>(storage->data);
+    return inline_as<date_t>();
   }
   void set_date(const date_t& val) {
-    set_type(DATE);
-    storage->data = val;
+    _set_inline(DATE, val);
   }
 
   bool is_long() const {
@@ -603,16 +648,14 @@ public:
   }
   long& as_long_lval() {
     VERIFY(is_long());
-    _dup();
-    return boost::get<long>(storage->data);
+    return inline_as<long>();
   }
   const long& as_long() const {
     VERIFY(is_long());
-    return boost::get<long>(storage->data);
+    return inline_as<long>();
   }
   void set_long(const long val) {
-    set_type(INTEGER);
-    storage->data = val;
+    _set_inline(INTEGER, val);
   }
 
   bool is_amount() const {
@@ -620,17 +663,18 @@ public:
   }
   amount_t& as_amount_lval() {
     VERIFY(is_amount());
-    _dup();
-    return boost::get<amount_t>(storage->data);
+    return inline_as<amount_t>();
   }
   const amount_t& as_amount() const {
     VERIFY(is_amount());
-    return boost::get<amount_t>(storage->data);
+    return inline_as<amount_t>();
   }
   void set_amount(const amount_t& val) {
     VERIFY(val.valid());
-    set_type(AMOUNT);
-    storage->data = val;
+    if (inline_type == AMOUNT)
+      inline_as<amount_t>() = val;
+    else
+      _set_inline(AMOUNT, val);
   }
 
   bool is_balance() const {
@@ -647,8 +691,10 @@ public:
   }
   void set_balance(const balance_t& val) {
     VERIFY(val.valid());
+    // `val' may refer to this value's own amount, so copy it first.
+    balance_t * temp = new balance_t(val);
     set_type(BALANCE);
-    storage->data = new balance_t(val);
+    storage->data = temp;
   }
 
   bool is_string() const {
@@ -710,8 +756,9 @@ public:
     return *boost::get<sequence_t *>(storage->data);
   }
   void set_sequence(const sequence_t& val) {
+    sequence_t * temp = new sequence_t(val);
     set_type(SEQUENCE);
-    storage->data = new sequence_t(val);
+    storage->data = temp;
   }
 
   /**
@@ -722,11 +769,10 @@ public:
   }
   scope_t * as_scope() const {
     VERIFY(is_scope());
-    return boost::get<scope_t *>(storage->data);
+    return inline_as<scope_t *>();
   }
   void set_scope(scope_t * val) {
-    set_type(SCOPE);
-    storage->data = val;
+    _set_inline(SCOPE, val);
   }
 
   /**
@@ -878,11 +924,7 @@ public:
     VERIFY(! is_null());
 
     if (! is_sequence()) {
-#if BOOST_VERSION >= 103700
-      storage.reset();
-#else
-      storage = intrusive_ptr<storage_t>();
-#endif
+      set_type(VOID);
     } else {
       as_sequence_lval().pop_back();
 
@@ -534,25 +534,28 @@ expr_t::ptr_op_t xact_t::lookup(const symbol_t::kind_t kind,
   if (kind != symbol_t::FUNCTION)
     return item_t::lookup(kind, name);
 
-  switch (name[0]) {
-  case 'a':
+  switch (hash_name(name.c_str())) {
+  case hash_name("any"):
     if (name == "any")
       return WRAP_FUNCTOR(&fn_any);
-    else if (name == "all")
+    break;
+  case hash_name("all"):
+    if (name == "all")
       return WRAP_FUNCTOR(&fn_all);
     break;
 
-  case 'c':
+  case hash_name("code"):
     if (name == "code")
       return WRAP_FUNCTOR(get_wrapper<&get_code>);
     break;
 
-  case 'm':
+  case hash_name("magnitude"):
     if (name == "magnitude")
       return WRAP_FUNCTOR(get_wrapper<&get_magnitude>);
     break;
 
-  case 'p':
+  case hash_name("p"):
+  case hash_name("payee"):
     if (name[1] == '\0' || name == "payee")
       return WRAP_FUNCTOR(get_wrapper<&get_payee>);
     break;
@@ -577,50 +580,6 @@ bool xact_t::valid() const
   return true;
 }
 
-namespace {
-  bool post_pred(expr_t::ptr_op_t op, post_t& post)
-  {
-    switch (op->kind) {
-    case expr_t::op_t::VALUE:
-      return op->as_value().to_boolean();
-
-    case expr_t::op_t::O_MATCH:
-      if (op->left()->kind == expr_t::op_t::IDENT &&
-          op->left()->as_ident() == "account" &&
-          op->right()->kind == expr_t::op_t::VALUE &&
-          op->right()->as_value().is_mask())
-        return op->right()->as_value().as_mask()
-          .match(post.reported_account()->fullname());
-      else
-        break;
-
-    case expr_t::op_t::O_EQ:
-      return post_pred(op->left(), post) == post_pred(op->right(), post);
-
-    case expr_t::op_t::O_NOT:
-      return ! post_pred(op->left(), post);
-
-    case expr_t::op_t::O_AND:
-      return post_pred(op->left(), post) && post_pred(op->right(), post);
-
-    case expr_t::op_t::O_OR:
-      return post_pred(op->left(), post) || post_pred(op->right(), post);
-
-    case expr_t::op_t::O_QUERY:
-      if (post_pred(op->left(), post))
-        return post_pred(op->right()->left(), post);
-      else
-        return post_pred(op->right()->right(), post);
-
-    default:
-      break;
-    }
-
-    throw_(calc_error, _("Unhandled operator"));
-    return false;
-  }
-}
-
 static string apply_format(const string& str, scope_t& scope)
 {
   if (contains(str, "%(")) {
@@ -649,32 +608,22 @@ void auto_xact_t::extend_xact(xact_base_t& xact, parse_context_t& context)
 
     bool matches_predicate = false;
     if (try_quick_match) {
-      try {
-        bool found_memoized_result = false;
-        if (! memoized_results.empty()) {
-          std::map<string, bool>::iterator i =
-            memoized_results.find(initial_post->account->fullname());
-          if (i != memoized_results.end()) {
-            found_memoized_result = true;
-            matches_predicate = (*i).second;
-          }
-        }
+      std::map<account_t *, bool>::iterator i =
+        memoized_results.find(initial_post->account);
+      if (i != memoized_results.end()) {
+        matches_predicate = (*i).second;
+      } else {
+        matches_predicate = predicate(bound_scope);
 
-        // Since the majority of people who use automated transactions simply
-        // match against account names, try using a *much* faster version of
-        // the predicate evaluator.
-        if (! found_memoized_result) {
-          matches_predicate = post_pred(predicate.get_op(), *initial_post);
+        // Since the majority of people who use automated transactions
+        // simply match against account names, the result can usually be
+        // remembered for each account.
+        if (predicate.tests_account_only())
           memoized_results.insert
-            (std::pair<string, bool>(initial_post->account->fullname(),
-                                     matches_predicate));
-        }
-      }
-      catch (...) {
-        DEBUG("xact.extend.fail",
-              "The quick matcher failed, going back to regular eval");
-        try_quick_match   = false;
-        matches_predicate = predicate(bound_scope);
+            (std::pair<account_t *, bool>(initial_post->account,
+                                          matches_predicate));
+        else
+          try_quick_match = false;
       }
     } else {
       matches_predicate = predicate(bound_scope);
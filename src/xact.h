@@ -48,6 +48,7 @@
 namespace ledger {
 
 class post_t;
+class account_t;
 class journal_t;
 class parse_context_t;
 
@@ -133,9 +134,9 @@ public:
 class auto_xact_t : public xact_base_t
 {
 public:
-  predicate_t            predicate;
-  bool                   try_quick_match;
-  std::map<string, bool> memoized_results;
+  predicate_t                 predicate;
+  bool                        try_quick_match;
+  std::map<account_t *, bool> memoized_results;
 
   optional<expr_t::check_expr_list> check_exprs;
 
@@ -1388,6 +1388,151 @@ BOOST_AUTO_TEST_CASE(testCommodityPrinting)
   BOOST_CHECK(x2.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testQuantitySerialization)
+{
+  amount_t x0;
+  amount_t x1("$-123.456");
+  amount_t x2("982340823.386238098235098235098235098");
+  amount_t x3(x2 / amount_t("-7.0"));
+  x3.set_keep_precision(true);
+
+  std::string buf;
+  x0.write_quantity(buf);
+  x1.write_quantity(buf);
+  x2.write_quantity(buf);
+  x3.write_quantity(buf);
+
+  const char * p   = buf.data();
+  const char * end = p + buf.length();
+  amount_t     y0, y1, y2, y3;
+
+  p += y0.read_quantity(p, end - p);
+  p += y1.read_quantity(p, end - p);
+  y1.set_commodity(x1.commodity());
+  p += y2.read_quantity(p, end - p);
+  p += y3.read_quantity(p, end - p);
+  BOOST_CHECK(p == end);
+
+  BOOST_CHECK(y0.is_null());
+  BOOST_CHECK_EQUAL(x1, y1);
+  BOOST_CHECK_EQUAL(x1.precision(), y1.precision());
+  BOOST_CHECK_EQUAL(x2, y2);
+  BOOST_CHECK_EQUAL(x3, y3);
+  BOOST_CHECK_EQUAL(x3.precision(), y3.precision());
+  BOOST_CHECK(y3.keep_precision());
+
+  BOOST_CHECK_THROW(y1.read_quantity(buf.data() + 1, 4), amount_error);
+
+  BOOST_CHECK(y1.valid());
+  BOOST_CHECK(y2.valid());
+  BOOST_CHECK(y3.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testInlineOverflow)
+{
+  // Quantities of up to 18 digits are held in 64 bits; results that
+  // outgrow that must carry on exactly in GMP.
+  amount_t x0("999999999999999999");
+  amount_t x1("0.000000000000000001");
+  amount_t x2("9999999999999999999");
+  amount_t x3("4611686018427387904");
+
+  BOOST_CHECK_EQUAL(amount_t("1000000000000000000"), x0 + amount_t(1L));
+  BOOST_CHECK_EQUAL(amount_t("999999999999999999.000000000000000001"),
+                    x0 + x1);
+  BOOST_CHECK_EQUAL(amount_t("999999999999999998000000000000000001"),
+                    x0 * x0);
+  BOOST_CHECK_EQUAL(string("10999999999999999998"), (x2 + x0).to_string());
+  BOOST_CHECK_EQUAL(x2, x0 * amount_t(10L) + amount_t(9L));
+  BOOST_CHECK_EQUAL(amount_t("-9223372036854775808"),
+                    amount_t(-9223372036854775807L) - amount_t(1L));
+  BOOST_CHECK_EQUAL(amount_t("9223372036854775808"),
+                    - (amount_t(-9223372036854775807L) - amount_t(1L)));
+  BOOST_CHECK_EQUAL(amount_t("2305843009213693952"), x3 / amount_t(2L));
+  BOOST_CHECK_EQUAL(amount_t("0.5"), amount_t(1L) / amount_t(2L));
+  BOOST_CHECK_EQUAL(1, x0.compare(x1));
+  BOOST_CHECK_EQUAL(-1, x0.compare(x2));
+  BOOST_CHECK_EQUAL(1, x2.compare(x0));
+
+  amount_t x4("$1.23");
+  amount_t x5("$4.567");
+  BOOST_CHECK_EQUAL(amount_t("$5.797"), x4 + x5);
+  BOOST_CHECK_EQUAL(3, (x4 + x5).precision());
+  BOOST_CHECK_EQUAL(amount_t("$5.61741"), x4 * x5);
+  BOOST_CHECK_EQUAL(amount_t("$12.3"), x4 * amount_t(10L));
+  BOOST_CHECK_EQUAL(amount_t("$1.23"), (x4 * x5) / x5);
+  BOOST_CHECK((x4 - amount_t("$1.23")).is_zero());
+
+  BOOST_CHECK(x0.valid());
+  BOOST_CHECK(x1.valid());
+  BOOST_CHECK(x2.valid());
+  BOOST_CHECK(x3.valid());
+  BOOST_CHECK(x4.valid());
+  BOOST_CHECK(x5.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testInlineRounding)
+{
+  // The same value must round alike whether it is held inline or in GMP.
+  amount_t x0("0.1249999995");
+  amount_t x1("0.1249999995000000000001");
+  amount_t x2("0.125");
+  amount_t x3("-0.125");
+  amount_t x4("-0.1250000000000000000001");
+  amount_t x5("12345678901234567850.5");
+  amount_t x6(x5);
+
+  x0.in_place_roundto(2);
+  x1.in_place_roundto(2);
+  x2.in_place_roundto(2);
+  x3.in_place_roundto(2);
+  x4.in_place_roundto(2);
+  x5.in_place_roundto(-2);
+  x6.in_place_roundto(0);
+
+  BOOST_CHECK_EQUAL(amount_t("0.12"), x0);
+  BOOST_CHECK_EQUAL(amount_t("0.12"), x1);
+  BOOST_CHECK_EQUAL(amount_t("0.13"), x2);
+  BOOST_CHECK_EQUAL(amount_t("-0.12"), x3);
+  BOOST_CHECK_EQUAL(amount_t("-0.13"), x4);
+  BOOST_CHECK_EQUAL(amount_t("12345678901234567900"), x5);
+  BOOST_CHECK_EQUAL(amount_t("12345678901234567851"), x6);
+
+  BOOST_CHECK(x0.valid());
+  BOOST_CHECK(x1.valid());
+  BOOST_CHECK(x2.valid());
+  BOOST_CHECK(x3.valid());
+  BOOST_CHECK(x4.valid());
+  BOOST_CHECK(x5.valid());
+  BOOST_CHECK(x6.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testAddInline)
+{
+  amount_t x0;
+  amount_t x1("$1.23");
+  amount_t x2("DM 1.00");
+  amount_t x3("9223372036854775807");
+
+  BOOST_CHECK(x0.add_inline(x1));
+  BOOST_CHECK_EQUAL(amount_t("$1.23"), x0);
+  BOOST_CHECK(x0.add_inline(amount_t("$4.567")));
+  BOOST_CHECK_EQUAL(amount_t("$5.797"), x0);
+  BOOST_CHECK_EQUAL(3, x0.precision());
+
+  // Nothing is added when operator+= would throw or need GMP.
+  BOOST_CHECK(! x0.add_inline(x2));
+  BOOST_CHECK(! x0.add_inline(amount_t()));
+  BOOST_CHECK_EQUAL(amount_t("$5.797"), x0);
+
+  amount_t x4(x3);
+  BOOST_CHECK(! x4.add_inline(amount_t(1L)));
+  BOOST_CHECK_EQUAL(x3, x4);
+
+  BOOST_CHECK(x0.valid());
+  BOOST_CHECK(x4.valid());
+}
+
 #endif // NOT_FOR_PYTHON
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -467,9 +467,9 @@ BOOST_AUTO_TEST_CASE(testRound)
 
   BOOST_CHECK_EQUAL(b0.rounded(), b0);
   BOOST_CHECK_EQUAL(b2.rounded(), b4);
-  BOOST_CHECK_EQUAL(b1.rounded(), b4);
+  BOOST_CHECK_EQUAL(b1.roundto(2).rounded(), b4);
 
-  b1.in_place_round();
+  b1.in_place_roundto(2);
   BOOST_CHECK_EQUAL(b1, b3);
 
   BOOST_CHECK(b0.valid());
@@ -525,4 +525,47 @@ BOOST_AUTO_TEST_CASE(testForZero)
   BOOST_CHECK(b1.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testManyCommodities)
+{
+  // More commodities than are kept inline in a balance_t.
+  const char * amounts[] = { "$1.00", "2 EUR", "3 CAD", "4 GBP",
+                             "5 JPY", "6 CHF", "7 AUD" };
+
+  balance_t b0;
+  balance_t b1;
+
+  for (int i = 0; i < 7; i++)
+    b0 += amount_t(amounts[i]);
+  for (int i = 6; i >= 0; i--)
+    b1 += amount_t(amounts[i]);
+
+  BOOST_CHECK_EQUAL(7U, b0.amounts.size());
+  BOOST_CHECK_EQUAL(b0, b1);
+
+  balance_t::amounts_map::const_iterator i = b0.amounts.begin();
+  balance_t::amounts_map::const_iterator j = i;
+  for (++j; j != b0.amounts.end(); ++i, ++j)
+    BOOST_CHECK(i->first < j->first);
+
+  balance_t b2(b0);
+  b2 -= amount_t("4 GBP");
+  b2 -= amount_t("$1.00");
+  BOOST_CHECK_EQUAL(5U, b2.amounts.size());
+  BOOST_CHECK(b2.amounts.find(&amount_t("4 GBP").commodity()) ==
+              b2.amounts.end());
+  BOOST_CHECK_EQUAL(amount_t("5 JPY"),
+                    *b2.commodity_amount(amount_t("5 JPY").commodity()));
+
+  b2 += amount_t("4 GBP");
+  b2 += amount_t("$1.00");
+  BOOST_CHECK_EQUAL(b0, b2);
+
+  b1 = balance_t(amount_t("$1.00"));
+  BOOST_CHECK_EQUAL(1U, b1.amounts.size());
+
+  BOOST_CHECK(b0.valid());
+  BOOST_CHECK(b1.valid());
+  BOOST_CHECK(b2.valid());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
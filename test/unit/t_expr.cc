@@ -8,6 +8,7 @@
 #include "predicate.h"
 #include "query.h"
 #include "op.h"
+#include "scope.h"
 
 using namespace ledger;
 
@@ -23,6 +24,26 @@ struct expr_fixture {
   }
 };
 
+namespace {
+  template <long N>
+  class typed_item_t : public scope_t
+  {
+  public:
+    virtual string description() {
+      return "item";
+    }
+    virtual expr_t::ptr_op_t lookup(const symbol_t::kind_t kind,
+                                    const string& name) {
+      if (kind == symbol_t::FUNCTION && name == "x")
+        return expr_t::op_t::wrap_value(N);
+      return NULL;
+    }
+    virtual bool lookup_by_type() const {
+      return true;
+    }
+  };
+}
+
 // 1.  foo and bar
 // 2.  'foo and bar'
 // 3.  (foo and bar)
@@ -331,4 +352,27 @@ BOOST_AUTO_TEST_CASE(testPredicateTokenizer16)
 #endif
 }
 
+BOOST_AUTO_TEST_CASE(testIdentSlots)
+{
+  empty_scope_t     empty;
+  typed_item_t<1L>  first;
+  typed_item_t<10L> second;
+
+  expr_t expr("x + 1");
+  expr.compile(empty);
+
+  // The identifier is resolved again whenever the item type changes.
+  bind_scope_t first_scope(empty, first);
+  bind_scope_t second_scope(empty, second);
+  BOOST_CHECK_EQUAL(value_t(2L), expr.calc(first_scope));
+  BOOST_CHECK_EQUAL(value_t(2L), expr.calc(first_scope));
+  BOOST_CHECK_EQUAL(value_t(11L), expr.calc(second_scope));
+  BOOST_CHECK_EQUAL(value_t(2L), expr.calc(first_scope));
+
+  context_scope_t context(second_scope);
+  BOOST_CHECK_EQUAL(value_t(11L), expr.calc(context));
+
+  BOOST_CHECK_THROW(expr.calc(empty), calc_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
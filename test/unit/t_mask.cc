@@ -0,0 +1,119 @@
+#define BOOST_TEST_DYN_LINK
+//#define BOOST_TEST_MODULE mask
+#include <boost/test/unit_test.hpp>
+
+#include <system.hh>
+
+#include "mask.h"
+
+using namespace ledger;
+
+struct mask_fixture {
+  mask_fixture() {}
+  ~mask_fixture() {}
+};
+
+BOOST_FIXTURE_TEST_SUITE(mask, mask_fixture)
+
+BOOST_AUTO_TEST_CASE(testLiterals)
+{
+  BOOST_CHECK(mask_t("food").match("Expenses:Food"));
+  BOOST_CHECK(mask_t("FOOD").match("Expenses:Food:Dining"));
+  BOOST_CHECK(! mask_t("food").match("Expenses:Fod"));
+  BOOST_CHECK(mask_t("^assets").match("Assets:Checking"));
+  BOOST_CHECK(! mask_t("^assets").match("Liabilities:Assets"));
+  BOOST_CHECK(mask_t("checking$").match("Assets:Checking"));
+  BOOST_CHECK(! mask_t("checking$").match("Assets:Checking:Old"));
+  BOOST_CHECK(mask_t("^assets:checking$").match("Assets:Checking"));
+  BOOST_CHECK(! mask_t("^assets:checking$").match("Assets:Checking2"));
+  BOOST_CHECK(mask_t("^expenses\\:food\\.").match("Expenses:Food.Dining"));
+  BOOST_CHECK(mask_t("10").match("2010"));
+  BOOST_CHECK(! mask_t("10").match("2001"));
+  BOOST_CHECK(mask_t("").match("anything"));
+  BOOST_CHECK(! mask_t("^x$").match(""));
+}
+
+BOOST_AUTO_TEST_CASE(testAgreesWithRegex)
+{
+  const char * patterns[] = {
+    "food", "Food", "^assets", "checking$", "^Assets:Checking$", "1 0",
+    "a\\.b", "\\$", "e\\:f", "^$", "^", "$", "ß", "k", "s$", "^a.c",
+    "ex|in", "\\<food", "o{2}", "[a-c]", NULL
+  };
+  const char * texts[] = {
+    "", "Expenses:Food", "Assets:Checking", "Assets:Checking\nMore",
+    "a.b", "$10", "1 0", "Straße", "Kelvin \xe2\x84\xaa", "abc",
+    "Income", "foo\r", NULL
+  };
+
+  for (const char ** p = patterns; *p; p++) {
+    mask_t mask(*p);
+    for (const char ** t = texts; *t; t++) {
+      string text(*t);
+#if HAVE_BOOST_REGEX_UNICODE
+      bool expected = boost::u32regex_search(text, mask.expr);
+#else
+      bool expected = boost::regex_search(text, mask.expr);
+#endif
+      BOOST_CHECK_MESSAGE(mask.match(text) == expected,
+                          "/" << *p << "/ =~ \"" << text << "\"");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testSetsAgreeWithMasks)
+{
+  const char * patterns[] = {
+    "^amazon", "mktp$", "^Whole Foods$", "amazon.*prime", "shell oil",
+    "^(abc|def)", "a+b", "x?food", "store #[0-9]+", "market", "^$", "",
+    "[.]com$", "\\bgas\\b", "o{2}d", "(?i)foo", "caf\xc3\xa9",
+    "\\x41BC", "\\x{44}ef", "\\cAbc", "\\0101bc", NULL
+  };
+  const char * texts[] = {
+    "", "AMAZON MKTP US", "Amazon Prime Video", "Whole Foods",
+    "Whole Foods Market", "SHELL OIL 123", "def ghi", "aab", "bfood",
+    "Store #42", "ebay.com", "Gas Station", "goood", "Caf\xc3\xa9 Bleu",
+    "Super\nMarket", "ABC", "x\x01" "bc", NULL
+  };
+
+  mask_set_t set;
+  for (const char ** p = patterns; *p; p++)
+    set.push_back(mask_t(*p));
+
+  // Check every suffix of the list, so that each mask is the first to
+  // match some text, and match after every mask is added, so that masks
+  // are also found before the automaton covers them.
+  for (const char ** first = patterns; *first; first++) {
+    mask_set_t masks;
+    std::vector<mask_t> list;
+    for (const char ** p = first; *p; p++) {
+      masks.push_back(mask_t(*p));
+      list.push_back(mask_t(*p));
+
+      for (const char ** t = texts; *t; t++) {
+        std::size_t expected = 0;
+        while (expected < list.size() && ! list[expected].match(*t))
+          expected++;
+        BOOST_CHECK_MESSAGE(masks.match(*t) == expected,
+                            "\"" << *t << "\" from /" << *first << "/ to /"
+                            << *p << "/");
+      }
+    }
+  }
+
+  BOOST_CHECK_EQUAL(set.match("AMAZON MKTP US"), 0U);
+  BOOST_CHECK_EQUAL(set.match("Whole Foods"), 2U);
+  BOOST_CHECK_EQUAL(set.match("Super Market"), 9U);
+}
+
+BOOST_AUTO_TEST_CASE(testGlobs)
+{
+  mask_t mask;
+  mask.assign_glob("Expenses:*");
+  BOOST_CHECK(mask.match("Expenses:Food"));
+  mask.assign_glob("*Food");
+  BOOST_CHECK(mask.match("Expenses:Food"));
+  BOOST_CHECK(! mask.match("Assets"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,236 @@
+#define BOOST_TEST_DYN_LINK
+//#define BOOST_TEST_MODULE session
+#include <boost/test/unit_test.hpp>
+
+#include <system.hh>
+
+#include "session.h"
+#include "report.h"
+#include "journal.h"
+#include "xact.h"
+#include "pool.h"
+#include "cache.h"
+
+using namespace ledger;
+
+struct session_fixture {
+  session_t session;
+  report_t  report;
+  path      dir;
+
+  session_fixture() : report(session) {
+    set_session_context(&session);
+    scope_t::default_scope = &report;
+
+    dir = filesystem::temp_directory_path() /
+      filesystem::unique_path("ledger-session-%%%%-%%%%-%%%%");
+    filesystem::create_directory(dir);
+
+    // Keep any ~/.pricedb out of the journal
+    write("prices.db", "");
+    session.HANDLER(price_db_).on("test", (dir / "prices.db").string());
+  }
+
+  ~session_fixture() {
+    filesystem::remove_all(dir);
+    scope_t::default_scope = NULL;
+    set_session_context(NULL);
+  }
+
+  path write(const string& name, const string& text, bool append = false) {
+    path pathname(dir / name);
+    ofstream out(pathname, append ? std::ios::app : std::ios::trunc);
+    out << text;
+    return pathname;
+  }
+
+  path append(const string& name, const string& text) {
+    return write(name, text, true);
+  }
+
+  void add_data_file(const path& pathname) {
+    session.HANDLER(file_).data_files.insert(pathname);
+  }
+};
+
+namespace {
+  string xact(const string& date, const string& payee) {
+    return (date + " " + payee + "\n"
+            "    Expenses:Food                $10.00\n"
+            "    Assets:Cash\n\n");
+  }
+
+  string read_file(const path& pathname) {
+    ifstream in(pathname, std::ios::binary);
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    return buf.str();
+  }
+
+  struct price_counter {
+    std::size_t& count;
+    price_counter(std::size_t& _count) : count(_count) {}
+    void operator()(const commodity_t&, const datetime_t&, const amount_t&) {
+      count++;
+    }
+  };
+
+  std::size_t count_prices(commodity_pool_t& pool) {
+    std::size_t count = 0;
+    pool.commodity_price_history.map_all_prices(price_counter(count));
+    return count;
+  }
+}
+
+BOOST_FIXTURE_TEST_SUITE(session, session_fixture)
+
+BOOST_AUTO_TEST_CASE(testReloadAppendedData)
+{
+  add_data_file(write("a.dat", xact("2012/01/01", "One") +
+                      xact("2012/01/02", "Two")));
+  session.read_journal_files();
+  BOOST_CHECK_EQUAL(2U, session.journal->xacts.size());
+
+  // Nothing has changed
+  BOOST_CHECK(session.read_appended_data());
+  BOOST_CHECK_EQUAL(2U, session.journal->xacts.size());
+
+  append("a.dat", xact("2012/01/03", "Three"));
+  BOOST_CHECK(session.read_appended_data());
+  BOOST_CHECK_EQUAL(3U, session.journal->xacts.size());
+  BOOST_CHECK_EQUAL(string("Three"), session.journal->xacts.back()->payee);
+
+  append("a.dat", xact("2012/01/04", "Four"));
+  session.reload_journal_files();
+  BOOST_CHECK_EQUAL(4U, session.journal->xacts.size());
+  BOOST_CHECK_EQUAL(string("Four"), session.journal->xacts.back()->payee);
+}
+
+BOOST_AUTO_TEST_CASE(testReloadEditedData)
+{
+  path pathname =
+    write("a.dat", xact("2012/01/01", "One") + xact("2012/01/02", "Two"));
+  add_data_file(pathname);
+  session.read_journal_files();
+
+  // A change before the end, even one keeping the size, means the whole
+  // file must be parsed again.
+  write("a.dat", xact("2012/01/01", "Un") + xact("2012/01/02", "Two") +
+        xact("2012/01/03", "Three"));
+  BOOST_CHECK(! session.read_appended_data());
+
+  session.reload_journal_files();
+  BOOST_CHECK_EQUAL(3U, session.journal->xacts.size());
+  BOOST_CHECK_EQUAL(string("Un"), session.journal->xacts.front()->payee);
+
+  // So does a line continuing the last entry read
+  append("a.dat", "    ; Note: late\n");
+  BOOST_CHECK(! session.read_appended_data());
+}
+
+BOOST_AUTO_TEST_CASE(testReloadUnterminatedBlock)
+{
+  add_data_file(write("a.dat", xact("2012/01/01", "One") +
+                      "comment\nNot ended\n"));
+  session.read_journal_files();
+  BOOST_CHECK_EQUAL(1U, session.journal->xacts.size());
+
+  // The appended text is still inside the comment block
+  append("a.dat", xact("2012/01/02", "Two") + "end comment\n" +
+         xact("2012/01/03", "Three"));
+  BOOST_CHECK(! session.read_appended_data());
+
+  session.reload_journal_files();
+  BOOST_CHECK_EQUAL(2U, session.journal->xacts.size());
+  BOOST_CHECK_EQUAL(string("Three"), session.journal->xacts.back()->payee);
+}
+
+BOOST_AUTO_TEST_CASE(testReloadSeveralFiles)
+{
+  add_data_file(write("a.dat", xact("2012/01/01", "One")));
+  add_data_file(write("b.dat", xact("2012/02/01", "Two")));
+  session.read_journal_files();
+  BOOST_CHECK_EQUAL(2U, session.journal->xacts.size());
+
+  // Only text appended to the last file read can be parsed by itself
+  append("a.dat", xact("2012/01/02", "Three"));
+  BOOST_CHECK(! session.read_appended_data());
+
+  session.reload_journal_files();
+  BOOST_CHECK_EQUAL(3U, session.journal->xacts.size());
+
+  append("b.dat", xact("2012/02/02", "Four"));
+  BOOST_CHECK(session.read_appended_data());
+  BOOST_CHECK_EQUAL(4U, session.journal->xacts.size());
+  BOOST_CHECK_EQUAL(string("Four"), session.journal->xacts.back()->payee);
+}
+
+BOOST_AUTO_TEST_CASE(testTruncatedCacheLeavesPool)
+{
+  add_data_file(write("a.dat",
+                      "D $1,000.00\n\n"
+                      "P 2012/01/01 EUR $1.25\n\n"
+                      "2012/01/02 Exchange\n"
+                      "    Assets:Euros           10 EUR {$1.20}\n"
+                      "    Assets:Cash\n"));
+  session.read_journal_files();
+
+  path cache(dir / "a.cache");
+  BOOST_REQUIRE(write_journal_cache(cache, *session.journal, "test"));
+  string whole(read_file(cache));
+
+  // The header ends with the length and hash of the contents.  Cut the
+  // contents in half and make these agree, so that the damage is only
+  // found while the commodities and postings are being read.
+  std::size_t    header;
+  uint_least64_t length = 0;
+  for (header = 16; header < whole.length(); header++) {
+    std::memcpy(&length, whole.data() + header - 16, sizeof(length));
+    if (length == whole.length() - header)
+      break;
+  }
+  BOOST_REQUIRE(header < whole.length());
+
+  string body(whole, header, static_cast<std::size_t>(length / 2));
+  uint_least64_t body_length = body.length();
+  file_hash_t    body_hash   = hash_file_bytes(body.data(), body.length());
+  string damaged(whole, 0, header);
+  damaged.replace(header - 16, 8,
+                  reinterpret_cast<const char *>(&body_length), 8);
+  damaged.replace(header - 8, 8,
+                  reinterpret_cast<const char *>(&body_hash), 8);
+  write("a.cache", damaged + body);
+
+  shared_ptr<commodity_pool_t> saved(commodity_pool_t::current_pool);
+  commodity_pool_t::current_pool.reset(new commodity_pool_t);
+  {
+    commodity_pool_t& pool(*commodity_pool_t::current_pool);
+    commodity_t *     euro = pool.create("EUR");
+    pool.create("$");
+    std::size_t       count = pool.commodities.size();
+
+    {
+      journal_t journal;
+      BOOST_CHECK(! read_journal_cache(cache, journal, "test"));
+    }
+    BOOST_CHECK_EQUAL(count, pool.commodities.size());
+    BOOST_CHECK(pool.annotated_commodities.empty());
+    BOOST_CHECK(! pool.default_commodity);
+    BOOST_CHECK_EQUAL(0, euro->flags());
+    BOOST_CHECK_EQUAL(0U, count_prices(pool));
+
+    write("a.cache", whole);
+    {
+      journal_t journal;
+      BOOST_CHECK(read_journal_cache(cache, journal, "test"));
+      BOOST_CHECK_EQUAL(1U, journal.xacts.size());
+    }
+    BOOST_CHECK_EQUAL(1U, pool.annotated_commodities.size());
+    BOOST_CHECK(pool.default_commodity == pool.find("$"));
+    BOOST_CHECK(euro->has_flags(COMMODITY_SAW_ANNOTATED));
+    BOOST_CHECK_EQUAL(1U, count_prices(pool));
+  }
+  commodity_pool_t::current_pool = saved;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
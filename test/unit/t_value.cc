@@ -711,5 +711,44 @@ BOOST_AUTO_TEST_CASE(testNegation)
   BOOST_CHECK(v15.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testInlineReassignment)
+{
+  value_t v1(amount_t("$1.50"));
+  value_t v2(v1);
+
+  v2 += amount_t("$1.00");
+  BOOST_CHECK_EQUAL(v1, value_t(amount_t("$1.50")));
+  BOOST_CHECK_EQUAL(v2, value_t(amount_t("$2.50")));
+
+  v1 = v1;
+  BOOST_CHECK_EQUAL(v1, value_t(amount_t("$1.50")));
+
+  // Moving between inline and stored types must release the old data.
+  v1.set_balance(v1.as_amount());
+  BOOST_CHECK(v1.is_balance());
+  BOOST_CHECK_EQUAL(v1, value_t(balance_t("$1.50")));
+  v1.set_long(3L);
+  BOOST_CHECK(v1.is_long());
+  v1.set_string("abc");
+  BOOST_CHECK(v1.is_string());
+  v1.set_date(parse_date("2014/08/14"));
+  BOOST_CHECK(v1.is_date());
+  v1 = v2;
+  BOOST_CHECK_EQUAL(v1, v2);
+
+  value_t v3;
+  v3.push_back(value_t(amount_t("2 EUR")));
+  v3.push_back(value_t(true));
+  v3.pop_back();
+  BOOST_CHECK(v3.is_amount());
+  BOOST_CHECK_EQUAL(v3, value_t(amount_t("2 EUR")));
+  v3.pop_back();
+  BOOST_CHECK(v3.is_null());
+
+  BOOST_CHECK(v1.valid());
+  BOOST_CHECK(v2.valid());
+  BOOST_CHECK(v3.valid());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 